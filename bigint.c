@@ -0,0 +1,240 @@
+#include "bigint.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* **************************************************************** */
+
+struct bigint_s {
+  unsigned int size;     // number of significant limbs (0 for zero)
+  unsigned int capacity; // number of allocated limbs
+  uint32_t* limbs;       // little-endian limbs
+};
+
+/* **************************************************************** */
+
+static void _reserve(bigint* a, unsigned int capacity) {
+  if (capacity <= a->capacity) return;
+  if (capacity < 2 * a->capacity) capacity = 2 * a->capacity;
+  a->limbs = realloc(a->limbs, capacity * sizeof(uint32_t));
+  assert(a->limbs);
+  memset(a->limbs + a->capacity, 0, (capacity - a->capacity) * sizeof(uint32_t));
+  a->capacity = capacity;
+}
+
+/* **************************************************************** */
+
+static void _normalize(bigint* a) {
+  while (a->size > 0 && a->limbs[a->size - 1] == 0) a->size--;
+}
+
+/* **************************************************************** */
+
+bigint* bigint_new(uint64_t v) {
+  bigint* a = malloc(sizeof(bigint));
+  assert(a);
+  a->size = 0;
+  a->capacity = 0;
+  a->limbs = NULL;
+  _reserve(a, 2);
+  bigint_set_u64(a, v);
+  return a;
+}
+
+/* **************************************************************** */
+
+bigint* bigint_new_limbs(const uint32_t* limbs, unsigned int size) {
+  bigint* a = bigint_new(0);
+  _reserve(a, size);
+  memcpy(a->limbs, limbs, size * sizeof(uint32_t));
+  a->size = size;
+  _normalize(a);
+  return a;
+}
+
+/* **************************************************************** */
+
+bigint* bigint_copy(const bigint* a) {
+  return bigint_new_limbs(a->limbs, a->size);
+}
+
+/* **************************************************************** */
+
+void bigint_free(bigint* a) {
+  if (!a) return;
+  free(a->limbs);
+  free(a);
+}
+
+/* **************************************************************** */
+
+void bigint_set(bigint* a, const bigint* b) {
+  if (a == b) return;
+  _reserve(a, b->size);
+  memcpy(a->limbs, b->limbs, b->size * sizeof(uint32_t));
+  memset(a->limbs + b->size, 0, (a->capacity - b->size) * sizeof(uint32_t));
+  a->size = b->size;
+}
+
+/* **************************************************************** */
+
+void bigint_set_u64(bigint* a, uint64_t v) {
+  memset(a->limbs, 0, a->capacity * sizeof(uint32_t));
+  a->limbs[0] = (uint32_t)v;
+  a->limbs[1] = (uint32_t)(v >> 32);
+  a->size = 2;
+  _normalize(a);
+}
+
+/* **************************************************************** */
+
+void bigint_add(bigint* a, const bigint* b) {
+  unsigned int size = (a->size > b->size ? a->size : b->size) + 1;
+  _reserve(a, size);
+  uint64_t carry = 0;
+  for (unsigned int k = 0; k < size; k++) {
+    uint64_t sum = carry + a->limbs[k] + (k < b->size ? b->limbs[k] : 0);
+    a->limbs[k] = (uint32_t)sum;
+    carry = sum >> 32;
+  }
+  a->size = size;
+  _normalize(a);
+}
+
+/* **************************************************************** */
+
+void bigint_sub(bigint* a, const bigint* b) {
+  assert(bigint_cmp(a, b) >= 0);
+  int64_t borrow = 0;
+  for (unsigned int k = 0; k < a->size; k++) {
+    int64_t diff = (int64_t)a->limbs[k] - (k < b->size ? b->limbs[k] : 0) -
+                   borrow;
+    borrow = diff < 0;
+    a->limbs[k] = (uint32_t)(diff + (borrow ? ((int64_t)1 << 32) : 0));
+  }
+  _normalize(a);
+}
+
+/* **************************************************************** */
+
+void bigint_mul(bigint* a, const bigint* b) {
+  if (a->size == 0 || b->size == 0) {
+    bigint_set_u64(a, 0);
+    return;
+  }
+  unsigned int size = a->size + b->size;
+  uint32_t* res = calloc(size, sizeof(uint32_t));
+  assert(res);
+  for (unsigned int i = 0; i < a->size; i++) {
+    uint64_t carry = 0;
+    for (unsigned int j = 0; j < b->size; j++) {
+      uint64_t cur = (uint64_t)a->limbs[i] * b->limbs[j] + res[i + j] + carry;
+      res[i + j] = (uint32_t)cur;
+      carry = cur >> 32;
+    }
+    res[i + b->size] = (uint32_t)carry;
+  }
+  _reserve(a, size);
+  memcpy(a->limbs, res, size * sizeof(uint32_t));
+  a->size = size;
+  _normalize(a);
+  free(res);
+}
+
+/* **************************************************************** */
+
+void bigint_mul_u32(bigint* a, uint32_t m) {
+  _reserve(a, a->size + 1);
+  uint64_t carry = 0;
+  for (unsigned int k = 0; k < a->size; k++) {
+    uint64_t cur = (uint64_t)a->limbs[k] * m + carry;
+    a->limbs[k] = (uint32_t)cur;
+    carry = cur >> 32;
+  }
+  a->limbs[a->size++] = (uint32_t)carry;
+  _normalize(a);
+}
+
+/* **************************************************************** */
+
+void bigint_shl(bigint* a, unsigned int n) {
+  if (a->size == 0) return;
+  unsigned int words = n / 32, bits = n % 32;
+  unsigned int size = a->size + words + 1;
+  _reserve(a, size);
+  for (int k = (int)size - 1; k >= 0; k--) {
+    int src = k - (int)words;
+    uint32_t hi = (src >= 0 && src < (int)a->size) ? a->limbs[src] : 0;
+    uint32_t lo = (src >= 1 && src - 1 < (int)a->size) ? a->limbs[src - 1] : 0;
+    a->limbs[k] = bits ? (hi << bits) | (lo >> (32 - bits)) : hi;
+  }
+  a->size = size;
+  _normalize(a);
+}
+
+/* **************************************************************** */
+
+int bigint_cmp(const bigint* a, const bigint* b) {
+  if (a->size != b->size) return a->size < b->size ? -1 : 1;
+  for (int k = (int)a->size - 1; k >= 0; k--)
+    if (a->limbs[k] != b->limbs[k]) return a->limbs[k] < b->limbs[k] ? -1 : 1;
+  return 0;
+}
+
+/* **************************************************************** */
+
+bool bigint_is_zero(const bigint* a) { return a->size == 0; }
+
+/* **************************************************************** */
+
+uint64_t bigint_to_u64(const bigint* a) {
+  if (a->size > 2) return UINT64_MAX;
+  uint64_t v = 0;
+  for (int k = (int)a->size - 1; k >= 0; k--) v = (v << 32) | a->limbs[k];
+  return v;
+}
+
+/* **************************************************************** */
+
+double bigint_to_double(const bigint* a) {
+  double v = 0.0;
+  for (int k = (int)a->size - 1; k >= 0; k--) v = v * 4294967296.0 + a->limbs[k];
+  return v;
+}
+
+/* **************************************************************** */
+
+char* bigint_to_string(const bigint* a) {
+  // at most 10 decimal digits per limb
+  unsigned int max_len = 10 * a->size + 1;
+  char* str = malloc(max_len + 1);
+  assert(str);
+  uint32_t* tmp = malloc((a->size + 1) * sizeof(uint32_t));
+  assert(tmp);
+  memcpy(tmp, a->limbs, a->size * sizeof(uint32_t));
+  unsigned int size = a->size, len = 0;
+  do {
+    // divide tmp by 10 and push the remainder
+    uint64_t rem = 0;
+    for (int k = (int)size - 1; k >= 0; k--) {
+      uint64_t cur = (rem << 32) | tmp[k];
+      tmp[k] = (uint32_t)(cur / 10);
+      rem = cur % 10;
+    }
+    str[len++] = '0' + (char)rem;
+    while (size > 0 && tmp[size - 1] == 0) size--;
+  } while (size > 0);
+  for (unsigned int k = 0; k < len / 2; k++) {
+    char c = str[k];
+    str[k] = str[len - 1 - k];
+    str[len - 1 - k] = c;
+  }
+  str[len] = '\0';
+  free(tmp);
+  return str;
+}
+
+/* **************************************************************** */
@@ -0,0 +1,69 @@
+/**
+ * @brief Lightweight implementation of unsigned big integers.
+ * @details Numbers are stored as little-endian arrays of 32-bit limbs. They are
+ * used to count solutions without overflow.
+ **/
+
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//@{
+
+typedef struct bigint_s bigint;
+
+/** Creates a new big integer from a 64-bit value. */
+bigint* bigint_new(uint64_t v);
+
+/** Creates a new big integer from an array of @p size 32-bit limbs, least
+ * significant limb first. */
+bigint* bigint_new_limbs(const uint32_t* limbs, unsigned int size);
+
+/** Duplicates a big integer. */
+bigint* bigint_copy(const bigint* a);
+
+/** Frees the memory allocated for a big integer. */
+void bigint_free(bigint* a);
+
+/** Sets @p a to the value of @p b. */
+void bigint_set(bigint* a, const bigint* b);
+
+/** Sets @p a to a 64-bit value. */
+void bigint_set_u64(bigint* a, uint64_t v);
+
+/** Computes a += b. */
+void bigint_add(bigint* a, const bigint* b);
+
+/** Computes a -= b (a must not be smaller than b). */
+void bigint_sub(bigint* a, const bigint* b);
+
+/** Computes a *= b. */
+void bigint_mul(bigint* a, const bigint* b);
+
+/** Computes a *= m. */
+void bigint_mul_u32(bigint* a, uint32_t m);
+
+/** Computes a *= 2^n. */
+void bigint_shl(bigint* a, unsigned int n);
+
+/** Compares two big integers: returns -1, 0 or 1. */
+int bigint_cmp(const bigint* a, const bigint* b);
+
+/** Returns true if the big integer is zero. */
+bool bigint_is_zero(const bigint* a);
+
+/** Converts a big integer to 64 bits, saturating at UINT64_MAX. */
+uint64_t bigint_to_u64(const bigint* a);
+
+/** Converts a big integer to the nearest double (possibly infinite). */
+double bigint_to_double(const bigint* a);
+
+/** Returns the decimal representation of a big integer. The returned string
+ * must be freed by the caller. */
+char* bigint_to_string(const bigint* a);
+
+//@}
+
+#endif
@@ -32,6 +32,84 @@ direction* DIR_ARRAYS[] = {[FULL] = FULL_DIR,
                            [FULL_EXCLUDE] = FULL_DIR,
                            [ORTHO_EXCLUDE] = ORTHO_DIR};
 
+/* 3-bit masks of the neighbourhood in the rows above, at and below a square
+ * (bit 0 = left column, bit 1 = center column, bit 2 = right column) */
+uint NEIGH_MASKS[][3] = {[FULL] = {7, 7, 7},
+                         [ORTHO] = {2, 7, 2},
+                         [FULL_EXCLUDE] = {7, 5, 7},
+                         [ORTHO_EXCLUDE] = {2, 5, 2}};
+
+/* ************************************************************************** */
+/*                            BITBOARD KERNELS                                */
+/* ************************************************************************** */
+
+/* Extracts the 3-bit window of a bitboard row around column j (bit 0 for
+ * column j-1, bit 1 for column j, bit 2 for column j+1). Columns outside the
+ * grid read as 0, unless the game is wrapping. */
+static inline uint _row_window(cgame g, const uint64_t* bb, uint i, uint j) {
+  const uint64_t* row = bb + i * g->row_words;
+  if (j >= 1 && j + 1 < g->nb_cols && ((j - 1) >> 6) == ((j + 1) >> 6))
+    return (row[j >> 6] >> ((j - 1) & 63)) & 7;
+  uint w = 0;
+  uint left = (j > 0) ? j - 1 : g->nb_cols - 1;
+  uint right = (j + 1 < g->nb_cols) ? j + 1 : 0;
+  if ((j > 0 || g->wrapping) && (row[left >> 6] & BIT(left))) w |= 1;
+  if (row[j >> 6] & BIT(j)) w |= 2;
+  if ((j + 1 < g->nb_cols || g->wrapping) && (row[right >> 6] & BIT(right)))
+    w |= 4;
+  return w;
+}
+
+/* Counts the black, white and empty squares in the neighbourhood of the
+ * square (i, j), with shifts, masks and popcounts over the three rows. */
+static void _count_neighbors(cgame g, uint i, uint j, int* nb_black,
+                             int* nb_white, int* nb_empty) {
+  uint* masks = NEIGH_MASKS[g->neigh];
+  uint valid = 2;
+  if (j > 0 || g->wrapping) valid |= 1;
+  if (j + 1 < g->nb_cols || g->wrapping) valid |= 4;
+  int black = 0, white = 0, empty = 0;
+  for (int d = -1; d <= 1; d++) {
+    int ii = (int)i + d;
+    if (g->wrapping) ii = (ii + g->nb_rows) % g->nb_rows;
+    if (ii < 0 || ii >= (int)g->nb_rows) continue;
+    uint b = _row_window(g, g->black, ii, j);
+    uint w = _row_window(g, g->white, ii, j);
+    uint m = masks[d + 1];
+    black += __builtin_popcount(b & m);
+    white += __builtin_popcount(w & m);
+    empty += __builtin_popcount(~(b | w) & valid & m);
+  }
+  *nb_black = black;
+  *nb_white = white;
+  *nb_empty = empty;
+}
+
+/* Computes the status from the counters of a square. */
+static inline status _status(int nb_expected_black, int nb_black,
+                             int nb_empty) {
+  // === unconstrained square === //
+
+  if (nb_expected_black == UNCONSTRAINED)
+    return (nb_empty > 0) ? UNSATISFIED : SATISFIED;
+
+  // === numbered square === //
+
+  // errors
+  if (nb_black > nb_expected_black)  // too many black squares
+    return ERROR;
+  if (nb_black + nb_empty < nb_expected_black)  // too many white squares
+    return ERROR;
+
+  // unsatisfied
+  if (nb_empty > 0) return UNSATISFIED;
+
+  // if constrained
+  if (nb_black == nb_expected_black && nb_empty == 0) return SATISFIED;
+
+  return ERROR;
+}
+
 /* ************************************************************************** */
 /*                                 GAME BASIC                                 */
 /* ************************************************************************** */
@@ -51,7 +129,9 @@ game game_new_empty(void) {
 
 game game_copy(cgame g) {
   game gg = game_new_empty_ext(g->nb_rows, g->nb_cols, g->wrapping, g->neigh);
-  memcpy(gg->squares, g->squares, g->nb_rows * g->nb_cols * sizeof(square));
+  memcpy(gg->constraints, g->constraints, g->nb_rows * g->nb_cols);
+  memcpy(gg->black, g->black, g->nb_rows * g->row_words * sizeof(uint64_t));
+  memcpy(gg->white, g->white, g->nb_rows * g->row_words * sizeof(uint64_t));
   return gg;
 }
 
@@ -63,14 +143,11 @@ bool game_equal(cgame g1, cgame g2) {
   if (g1->nb_rows != g2->nb_rows) return false;
   if (g1->nb_cols != g2->nb_cols) return false;
 
-  for (uint i = 0; i < g1->nb_rows; i++)
-    for (uint j = 0; j < g1->nb_cols; j++) {
-      color c1 = COLOR(g1, i, j);
-      color c2 = COLOR(g2, i, j);
-      constraint n1 = CONSTRAINT(g1, i, j);
-      constraint n2 = CONSTRAINT(g2, i, j);
-      if (n1 != n2 || c1 != c2) return false;
-    }
+  uint nb_words = g1->nb_rows * g1->row_words;
+  if (memcmp(g1->constraints, g2->constraints, g1->nb_rows * g1->nb_cols))
+    return false;
+  if (memcmp(g1->black, g2->black, nb_words * sizeof(uint64_t))) return false;
+  if (memcmp(g1->white, g2->white, nb_words * sizeof(uint64_t))) return false;
 
   if (g1->wrapping != g2->wrapping) return false;
   if (g1->neigh != g2->neigh) return false;
@@ -82,7 +159,9 @@ bool game_equal(cgame g1, cgame g2) {
 
 void game_delete(game g) {
   if (!g) return;
-  free(g->squares);
+  free(g->constraints);
+  free(g->black);
+  free(g->white);
   queue_free_full(g->undo_stack, free);
   queue_free_full(g->redo_stack, free);
   free(g);
@@ -105,7 +184,7 @@ void game_set_color(game g, uint i, uint j, color c) {
   assert(i < g->nb_rows);
   assert(j < g->nb_cols);
   assert(c == BLACK || c == WHITE || c == EMPTY);
-  COLOR(g, i, j) = c;
+  SET_COLOR(g, i, j, c);
 }
 
 /* ************************************************************************** */
@@ -133,31 +212,9 @@ status game_get_status(cgame g, uint i, uint j) {
   assert(i < g->nb_rows);
   assert(j < g->nb_cols);
 
-  int nb_expected_black = CONSTRAINT(g, i, j);
-  int nb_black = game_nb_neighbors(g, i, j, BLACK);
-  // int nb_white = game_nb_neighbors(g, i, j, WHITE);
-  int nb_empty = game_nb_neighbors(g, i, j, EMPTY);
-
-  // === unconstrained square === //
-
-  if (nb_expected_black == UNCONSTRAINED && nb_empty > 0) return UNSATISFIED;
-  if (nb_expected_black == UNCONSTRAINED && nb_empty == 0) return SATISFIED;
-
-  // === numbered square === //
-
-  // errors
-  if (nb_black > nb_expected_black)  // too many black squares
-    return ERROR;
-  if (nb_black + nb_empty < nb_expected_black)  // too many white squares
-    return ERROR;
-
-  // unsatisfied
-  if (nb_empty > 0) return UNSATISFIED;
-
-  // if constrained
-  if (nb_black == nb_expected_black && nb_empty == 0) return SATISFIED;
-
-  return ERROR;
+  int nb_black, nb_white, nb_empty;
+  _count_neighbors(g, i, j, &nb_black, &nb_white, &nb_empty);
+  return _status(CONSTRAINT(g, i, j), nb_black, nb_empty);
 }
 
 /* ************************************************************************** */
@@ -197,18 +254,12 @@ int game_nb_neighbors(cgame g, uint i, uint j, color c) {
   assert(g);
   assert(i < g->nb_rows);
   assert(j < g->nb_cols);
-  uint count = 0;
-  direction* dir_array = DIR_ARRAYS[g->neigh];
-  uint dir_size = DIR_SIZES[g->neigh];
-
-  for (uint n = 0; n < dir_size; n++) {
-    direction dir = dir_array[n];
-    uint ii, jj;
-    bool valid = game_get_next_square(g, i, j, dir, &ii, &jj);
-    if (valid && game_get_color(g, ii, jj) == c) count++;
-  }
-
-  return count;
+  assert(c == BLACK || c == WHITE || c == EMPTY);
+  int nb_black, nb_white, nb_empty;
+  _count_neighbors(g, i, j, &nb_black, &nb_white, &nb_empty);
+  if (c == BLACK) return nb_black;
+  if (c == WHITE) return nb_white;
+  return nb_empty;
 }
 
 /* ************************************************************************** */
@@ -220,7 +271,7 @@ void game_play_move(game g, uint i, uint j, color c) {
   assert(c == BLACK || c == WHITE || c == EMPTY);
 
   color cc = COLOR(g, i, j);  // save current color
-  COLOR(g, i, j) = c;         // set color
+  SET_COLOR(g, i, j, c);      // set color
 
   // save history
   _stack_clear(g->redo_stack);
@@ -232,11 +283,22 @@ void game_play_move(game g, uint i, uint j, color c) {
 
 bool game_won(cgame g) {
   assert(g);
-  assert(g);
+
+  // when no square is empty, only the numbered squares must be checked
+  bool full = true;
+  for (uint i = 0; i < g->nb_rows && full; i++)
+    for (uint k = 0; k < g->row_words && full; k++) {
+      uint nb_bits = MIN(64, g->nb_cols - 64 * k);
+      uint64_t mask = (nb_bits == 64) ? ~(uint64_t)0 : BIT(nb_bits) - 1;
+      uint w = i * g->row_words + k;
+      if ((g->black[w] | g->white[w]) != mask) full = false;
+    }
 
   for (uint i = 0; i < g->nb_rows; i++)
-    for (uint j = 0; j < g->nb_cols; j++)
+    for (uint j = 0; j < g->nb_cols; j++) {
+      if (full && CONSTRAINT(g, i, j) == UNCONSTRAINED) continue;
       if (game_get_status(g, i, j) != SATISFIED) return false;
+    }
   return true;
 }
 
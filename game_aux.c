@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "game.h"
 #include "game_ext.h"
@@ -57,27 +58,95 @@ game game_default_solution(void) {
 
 /* ************************************************************************** */
 
-void game_print(cgame g) {
+/* number of decimal digits of n */
+static uint _nb_digits(uint n) {
+  uint d = 1;
+  while (n >= 10) {
+    n /= 10;
+    d++;
+  }
+  return d;
+}
+
+/* write n in decimal at p, and return the position after it */
+static char* _write_uint(char* p, uint n) {
+  uint d = _nb_digits(n);
+  for (uint k = d; k > 0; k--) {
+    p[k - 1] = '0' + n % 10;
+    n /= 10;
+  }
+  return p + d;
+}
+
+/* write the line of dashes above and below the grid */
+static char* _write_dashes(char* p, uint nb_cols) {
+  memset(p, ' ', 5);
+  p += 5;
+  memset(p, '-', 2 * nb_cols);
+  p += 2 * nb_cols;
+  *p++ = '\n';
+  return p;
+}
+
+/* ************************************************************************** */
+
+char* game_to_string(cgame g) {
   assert(g);
-  printf("     ");
-  for (uint j = 0; j < game_nb_cols(g); j++) printf("%d ", j);
-  printf("\n");
-  printf("     ");
-  for (uint j = 0; j < 2 * game_nb_cols(g); j++) printf("-");
-  printf("\n");
-  for (uint i = 0; i < game_nb_rows(g); i++) {
-    printf("  %d |", i);
-    for (uint j = 0; j < game_nb_cols(g); j++) {
+  uint nb_rows = game_nb_rows(g);
+  uint nb_cols = game_nb_cols(g);
+
+  // upper bound of the text size (a square takes at most 4 bytes in UTF-8)
+  size_t size = 5 + (size_t)nb_cols * (_nb_digits(nb_cols) + 1) + 1;
+  size += 2 * (5 + 2 * (size_t)nb_cols + 1);
+  size += (size_t)nb_rows * (2 + _nb_digits(nb_rows) + 2 + 5 * nb_cols + 2);
+  char* str = (char*)malloc(size + 1);
+  assert(str);
+
+  char* p = str;
+  memset(p, ' ', 5);
+  p += 5;
+  for (uint j = 0; j < nb_cols; j++) {
+    p = _write_uint(p, j);
+    *p++ = ' ';
+  }
+  *p++ = '\n';
+  p = _write_dashes(p, nb_cols);
+  for (uint i = 0; i < nb_rows; i++) {
+    *p++ = ' ';
+    *p++ = ' ';
+    p = _write_uint(p, i);
+    *p++ = ' ';
+    *p++ = '|';
+    for (uint j = 0; j < nb_cols; j++) {
       constraint n = game_get_constraint(g, i, j);
       color c = game_get_color(g, i, j);
-      char* ch = _square2str(n, c);
-      printf("%s ", ch);
+      const char* ch = _square2str(n, c);
+      size_t len = strlen(ch);
+      memcpy(p, ch, len);
+      p += len;
+      *p++ = ' ';
     }
-    printf("|\n");
+    *p++ = '|';
+    *p++ = '\n';
   }
-  printf("     ");
-  for (uint j = 0; j < 2 * game_nb_cols(g); j++) printf("-");
-  printf("\n");
+  p = _write_dashes(p, nb_cols);
+  *p = '\0';
+  assert((size_t)(p - str) <= size);
+
+  return str;
 }
 
 /* ************************************************************************** */
+
+void game_print_to(cgame g, FILE* f) {
+  assert(g && f);
+  char* str = game_to_string(g);
+  fwrite(str, 1, strlen(str), f);
+  free(str);
+}
+
+/* ************************************************************************** */
+
+void game_print(cgame g) { game_print_to(g, stdout); }
+
+/* ************************************************************************** */
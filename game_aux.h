@@ -8,6 +8,8 @@
 #ifndef __GAME_AUX_H__
 #define __GAME_AUX_H__
 
+#include <stdio.h>
+
 #include "game.h"
 
 /**
@@ -19,6 +21,26 @@
  **/
 void game_print(cgame g);
 
+/**
+ * @brief Prints a game as text on a given stream.
+ * @details The whole grid is rendered with @ref game_to_string and written
+ * with a single call.
+ * @param g the game
+ * @param f the output stream
+ * @pre @p g must be a valid pointer toward a game structure.
+ * @pre @p f must be a valid stream opened for writing.
+ **/
+void game_print_to(cgame g, FILE* f);
+
+/**
+ * @brief Renders a game as text in a single UTF-8 string.
+ * @details The text is the same as the one printed by @ref game_print.
+ * @param g the game
+ * @pre @p g must be a valid pointer toward a game structure.
+ * @return a null-terminated string, to be freed by the caller
+ **/
+char* game_to_string(cgame g);
+
 /**
  * @brief Creates the default game.
  * @details See the description of the default game in @ref index.
@@ -0,0 +1,546 @@
+/**
+ * @file game_cache.c
+ * @brief Component-caching model counter.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bigint.h"
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* default memory budget of the cache, in bytes */
+#define DEFAULT_BUDGET ((size_t)256 << 20)
+
+/* estimated memory used by a bigint, beyond the entry itself */
+#define BIGINT_BYTES 48
+
+/* A cached component: its canonical key (number of cells, sorted cells, then
+ * the residual need of its sorted constraints) and its number of solutions. */
+typedef struct entry_s {
+  struct entry_s* next;
+  uint64_t hash;
+  uint stamp;  // last time the entry was used
+  uint len;
+  bigint* count;
+  bigint** black;  // if not NULL, number of solutions with each cell black
+                   // (in the order of the key)
+  uint key[];
+} entry;
+
+/* Counter state. */
+typedef struct {
+  solver* s;
+  entry** buckets;  // hashed table of the cached components
+  uint capacity;    // number of buckets (power of 2)
+  uint size;        // number of entries
+  size_t memory;    // estimated memory used by the entries
+  size_t budget;    // memory budget of the entries
+  uint clock;       // incremented at each use of the cache
+  uint generation;  // stamp of the marks below
+  uint* in_set;     // cell -> generation, if the cell is in the current set
+  uint* seen;       // cell -> generation, if the cell is already visited
+  uint* cons_seen;  // constraint -> generation, if already visited
+} counter;
+
+/* ************************************************************************** */
+/*                                  CACHE                                     */
+/* ************************************************************************** */
+
+static uint64_t _hash(const uint* key, uint len) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (uint i = 0; i < len; i++) {
+    h ^= key[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h ^ (h >> 29);
+}
+
+/* ************************************************************************** */
+
+static entry* _lookup(counter* c, const uint* key, uint len, uint64_t hash) {
+  for (entry* e = c->buckets[hash & (c->capacity - 1)]; e; e = e->next)
+    if (e->hash == hash && e->len == len &&
+        !memcmp(e->key, key, len * sizeof(uint)))
+      return e;
+  return NULL;
+}
+
+/* ************************************************************************** */
+
+static size_t _entry_bytes(const entry* e) {
+  size_t bytes = sizeof(entry) + e->len * sizeof(uint) + BIGINT_BYTES;
+  if (e->black) bytes += e->key[0] * (sizeof(bigint*) + BIGINT_BYTES);
+  return bytes;
+}
+
+/* ************************************************************************** */
+
+static void _entry_free(entry* e) {
+  bigint_free(e->count);
+  for (uint i = 0; e->black && i < e->key[0]; i++) bigint_free(e->black[i]);
+  free(e->black);
+  free(e);
+}
+
+/* ************************************************************************** */
+
+/* Evicts the entries that were not used during the older half of the time. */
+static void _evict(counter* c) {
+  uint oldest = c->clock;
+  for (uint b = 0; b < c->capacity; b++)
+    for (entry* e = c->buckets[b]; e; e = e->next)
+      if (e->stamp < oldest) oldest = e->stamp;
+  uint limit = oldest + (c->clock - oldest) / 2 + 1;
+
+  for (uint b = 0; b < c->capacity; b++) {
+    entry** prev = &c->buckets[b];
+    while (*prev) {
+      entry* e = *prev;
+      if (e->stamp < limit) {
+        *prev = e->next;
+        c->memory -= _entry_bytes(e);
+        c->size--;
+        _entry_free(e);
+      } else {
+        prev = &e->next;
+      }
+    }
+  }
+}
+
+/* ************************************************************************** */
+
+/* Caches a component, with the counts of its cells black if black is not
+ * NULL. */
+static void _insert(counter* c, const uint* key, uint len, uint64_t hash,
+                    const bigint* count, bigint* const* black) {
+  entry* e = (entry*)malloc(sizeof(entry) + len * sizeof(uint));
+  assert(e);
+  e->hash = hash;
+  e->stamp = c->clock;
+  e->len = len;
+  e->count = bigint_copy(count);
+  e->black = NULL;
+  if (black) {
+    e->black = (bigint**)malloc((key[0] + 1) * sizeof(bigint*));
+    assert(e->black);
+    for (uint i = 0; i < key[0]; i++) e->black[i] = bigint_copy(black[i]);
+  }
+  memcpy(e->key, key, len * sizeof(uint));
+  c->memory += _entry_bytes(e);
+  if (c->memory > c->budget) _evict(c);
+
+  // grow the table
+  if (c->size >= c->capacity) {
+    uint capacity = 2 * c->capacity;
+    entry** buckets = (entry**)calloc(capacity, sizeof(entry*));
+    assert(buckets);
+    for (uint b = 0; b < c->capacity; b++)
+      while (c->buckets[b]) {
+        entry* f = c->buckets[b];
+        c->buckets[b] = f->next;
+        f->next = buckets[f->hash & (capacity - 1)];
+        buckets[f->hash & (capacity - 1)] = f;
+      }
+    free(c->buckets);
+    c->buckets = buckets;
+    c->capacity = capacity;
+  }
+
+  e->next = c->buckets[hash & (c->capacity - 1)];
+  c->buckets[hash & (c->capacity - 1)] = e;
+  c->size++;
+}
+
+/* ************************************************************************** */
+/*                                COMPONENTS                                  */
+/* ************************************************************************** */
+
+static int _cmp_uint(const void* a, const void* b) {
+  uint x = *(const uint*)a, y = *(const uint*)b;
+  return (x > y) - (x < y);
+}
+
+/* ************************************************************************** */
+
+/* Groups the empty cells among cells[0..n-1] by connected component. The
+ * cells of component i are out[start[i] .. start[i+1]-1]. */
+static uint _split(counter* c, const uint* cells, uint n, uint* out,
+                   uint* start) {
+  solver* s = c->s;
+  uint gen = ++c->generation;
+  for (uint i = 0; i < n; i++)
+    if (s->colors[cells[i]] == EMPTY) c->in_set[cells[i]] = gen;
+
+  uint nb_comps = 0, size = 0;
+  for (uint i = 0; i < n; i++) {
+    uint x = cells[i];
+    if (c->in_set[x] != gen || c->seen[x] == gen) continue;
+    start[nb_comps++] = size;
+    c->seen[x] = gen;
+    out[size++] = x;
+    // breadth-first search, with out[] as the queue
+    for (uint q = start[nb_comps - 1]; q < size; q++) {
+      uint y = out[q];
+      for (uint p = s->cell_start[y]; p < s->cell_start[y + 1]; p++) {
+        uint k = s->cell_cons[p];
+        if (c->cons_seen[k] == gen) continue;
+        c->cons_seen[k] = gen;
+        for (uint r = s->cons_start[k]; r < s->cons_start[k + 1]; r++) {
+          uint z = s->cons_cells[r];
+          if (c->in_set[z] == gen && c->seen[z] != gen) {
+            c->seen[z] = gen;
+            out[size++] = z;
+          }
+        }
+      }
+    }
+  }
+  start[nb_comps] = size;
+  return nb_comps;
+}
+
+/* ************************************************************************** */
+
+/* Builds the canonical key of a component, whose cells get sorted. */
+static uint* _key(counter* c, uint* cells, uint n, uint* len) {
+  solver* s = c->s;
+  qsort(cells, n, sizeof(uint), _cmp_uint);
+  uint gen = ++c->generation;
+  uint nb_cons = 0;
+  for (uint i = 0; i < n; i++)
+    nb_cons += s->cell_start[cells[i] + 1] - s->cell_start[cells[i]];
+
+  uint* key = (uint*)malloc((1 + n + nb_cons) * sizeof(uint));
+  assert(key);
+  key[0] = n;
+  memcpy(key + 1, cells, n * sizeof(uint));
+  uint* cons = key + 1 + n;
+  nb_cons = 0;
+  for (uint i = 0; i < n; i++)
+    for (uint p = s->cell_start[cells[i]]; p < s->cell_start[cells[i] + 1];
+         p++) {
+      uint k = s->cell_cons[p];
+      if (c->cons_seen[k] == gen) continue;
+      c->cons_seen[k] = gen;
+      cons[nb_cons++] = k;
+    }
+  qsort(cons, nb_cons, sizeof(uint), _cmp_uint);
+  for (uint i = 0; i < nb_cons; i++)
+    cons[i] = s->cons_need[cons[i]] - s->cons_black[cons[i]];
+
+  *len = 1 + n + nb_cons;
+  return key;
+}
+
+/* ************************************************************************** */
+
+/* Chooses the cell of the component in the tightest constraint. */
+static uint _choose(const solver* s, const uint* cells, uint n) {
+  uint best = cells[0];
+  int best_empty = INT32_MAX;
+  uint best_degree = 0;
+  for (uint i = 0; i < n; i++) {
+    uint x = cells[i];
+    int empty = INT32_MAX;
+    for (uint p = s->cell_start[x]; p < s->cell_start[x + 1]; p++)
+      if (s->cons_empty[s->cell_cons[p]] < empty)
+        empty = s->cons_empty[s->cell_cons[p]];
+    uint degree = s->cell_start[x + 1] - s->cell_start[x];
+    if (empty < best_empty || (empty == best_empty && degree > best_degree)) {
+      best = x;
+      best_empty = empty;
+      best_degree = degree;
+    }
+  }
+  return best;
+}
+
+/* ************************************************************************** */
+
+static bigint* _count_component(counter* c, uint* cells, uint n);
+
+/* Counts the solutions over the empty cells among cells[0..n-1], as the
+ * product of the counts of their components. */
+static bigint* _count_cells(counter* c, const uint* cells, uint n) {
+  uint* out = (uint*)malloc((n + 1) * sizeof(uint));
+  uint* start = (uint*)malloc((n + 2) * sizeof(uint));
+  assert(out && start);
+  uint nb_comps = _split(c, cells, n, out, start);
+
+  bigint* count = bigint_new(1);
+  for (uint i = 0; i < nb_comps && !bigint_is_zero(count); i++) {
+    bigint* nb = _count_component(c, out + start[i], start[i + 1] - start[i]);
+    bigint_mul(count, nb);
+    bigint_free(nb);
+  }
+
+  free(out);
+  free(start);
+  return count;
+}
+
+/* ************************************************************************** */
+
+/* Counts the solutions of a connected component of empty cells. */
+static bigint* _count_component(counter* c, uint* cells, uint n) {
+  solver* s = c->s;
+  if (n == 1 && solver_is_free(s, cells[0])) return bigint_new(2);
+
+  uint len;
+  uint* key = _key(c, cells, n, &len);
+  uint64_t hash = _hash(key, len);
+  c->clock++;
+  entry* e = _lookup(c, key, len, hash);
+  if (e) {
+    e->stamp = c->clock;
+    free(key);
+    return bigint_copy(e->count);
+  }
+
+  // branch on the most constrained cell, then split again
+  uint x = _choose(s, cells, n);
+  bigint* count = bigint_new(0);
+  for (color col = WHITE; col <= BLACK; col++) {
+    uint mark = solver_mark(s);
+    s->nb_nodes++;
+    if (solver_assign(s, x, col) && solver_propagate(s)) {
+      bigint* nb = _count_cells(c, cells, n);
+      bigint_add(count, nb);
+      bigint_free(nb);
+    }
+    solver_undo(s, mark);
+  }
+
+  _insert(c, key, len, hash, count, NULL);
+  free(key);
+  return count;
+}
+
+/* ************************************************************************** */
+/*                               MARGINALS                                    */
+/* ************************************************************************** */
+
+/* Returns the index of a cell in a sorted array of cells. */
+static uint _index(const uint* cells, uint n, uint x) {
+  uint lo = 0, hi = n;
+  while (hi - lo > 1) {
+    uint mid = (lo + hi) / 2;
+    if (cells[mid] <= x)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* ************************************************************************** */
+
+static bigint* _marginals_component(counter* c, uint* cells, uint n,
+                                    bigint** black);
+
+/* Same as _count_cells, and sets black[i] to a new counter of the solutions
+ * with cells[i] black (the cells being sorted): in a component, it is the
+ * count of the component with the cell black, times the counts of the other
+ * components. */
+static bigint* _marginals_cells(counter* c, const uint* cells, uint n,
+                                bigint** black) {
+  solver* s = c->s;
+  uint* out = (uint*)malloc((n + 1) * sizeof(uint));
+  uint* start = (uint*)malloc((n + 2) * sizeof(uint));
+  bigint** sub = (bigint**)malloc((n + 1) * sizeof(bigint*));
+  assert(out && start && sub);
+  uint nb_comps = _split(c, cells, n, out, start);
+  bigint** counts = (bigint**)malloc((nb_comps + 1) * sizeof(bigint*));
+  assert(counts);
+
+  bigint* count = bigint_new(1);
+  uint nb_done = 0;
+  while (nb_done < nb_comps && !bigint_is_zero(count)) {
+    uint i = nb_done++;
+    counts[i] = _marginals_component(c, out + start[i], start[i + 1] - start[i],
+                                     sub + start[i]);
+    bigint_mul(count, counts[i]);
+  }
+
+  for (uint i = 0; i < n; i++) black[i] = NULL;
+  if (!bigint_is_zero(count)) {
+    // others = product of the counts of the components after i, then before
+    bigint** after = (bigint**)malloc((nb_comps + 1) * sizeof(bigint*));
+    assert(after);
+    after[nb_comps] = bigint_new(1);
+    for (uint i = nb_comps; i > 0; i--) {
+      after[i - 1] = bigint_copy(after[i]);
+      bigint_mul(after[i - 1], counts[i - 1]);
+    }
+    bigint* before = bigint_new(1);
+    for (uint i = 0; i < nb_comps; i++) {
+      bigint* others = bigint_copy(before);
+      bigint_mul(others, after[i + 1]);
+      for (uint q = start[i]; q < start[i + 1]; q++) {
+        bigint_mul(sub[q], others);
+        black[_index(cells, n, out[q])] = sub[q];
+      }
+      bigint_mul(before, counts[i]);
+      bigint_free(others);
+    }
+    bigint_free(before);
+    for (uint i = 0; i <= nb_comps; i++) bigint_free(after[i]);
+    free(after);
+  } else {
+    for (uint i = 0; i < nb_done; i++)
+      for (uint q = start[i]; q < start[i + 1]; q++) bigint_free(sub[q]);
+  }
+  // the cells assigned by the last decision, or already before
+  for (uint i = 0; i < n; i++)
+    if (black[i] == NULL)
+      black[i] = (s->colors[cells[i]] == BLACK && !bigint_is_zero(count))
+                     ? bigint_copy(count)
+                     : bigint_new(0);
+
+  for (uint i = 0; i < nb_done; i++) bigint_free(counts[i]);
+  free(counts);
+  free(sub);
+  free(out);
+  free(start);
+  return count;
+}
+
+/* ************************************************************************** */
+
+/* Same as _count_component, and sets black[i] to a new counter of the
+ * solutions with cells[i] black (once the cells are sorted). */
+static bigint* _marginals_component(counter* c, uint* cells, uint n,
+                                    bigint** black) {
+  solver* s = c->s;
+  if (n == 1 && solver_is_free(s, cells[0])) {
+    black[0] = bigint_new(1);
+    return bigint_new(2);
+  }
+
+  uint len;
+  uint* key = _key(c, cells, n, &len);
+  uint64_t hash = _hash(key, len);
+  c->clock++;
+  entry* e = _lookup(c, key, len, hash);
+  if (e) {
+    e->stamp = c->clock;
+    free(key);
+    for (uint i = 0; i < n; i++) black[i] = bigint_copy(e->black[i]);
+    return bigint_copy(e->count);
+  }
+
+  // branch on the most constrained cell, then split again
+  uint x = _choose(s, cells, n);
+  bigint* count = bigint_new(0);
+  bigint** branch = (bigint**)malloc((n + 1) * sizeof(bigint*));
+  assert(branch);
+  for (uint i = 0; i < n; i++) black[i] = bigint_new(0);
+  for (color col = WHITE; col <= BLACK; col++) {
+    uint mark = solver_mark(s);
+    s->nb_nodes++;
+    if (solver_assign(s, x, col) && solver_propagate(s)) {
+      bigint* nb = _marginals_cells(c, cells, n, branch);
+      bigint_add(count, nb);
+      bigint_free(nb);
+      for (uint i = 0; i < n; i++) {
+        bigint_add(black[i], branch[i]);
+        bigint_free(branch[i]);
+      }
+    }
+    solver_undo(s, mark);
+  }
+
+  _insert(c, key, len, hash, count, black);
+  free(branch);
+  free(key);
+  return count;
+}
+
+/* ************************************************************************** */
+/*                               CACHE ENGINE                                 */
+/* ************************************************************************** */
+
+static void _counter_init(counter* c, solver* s, size_t budget) {
+  c->s = s;
+  c->capacity = 1024;
+  c->buckets = (entry**)calloc(c->capacity, sizeof(entry*));
+  c->size = 0;
+  c->memory = 0;
+  c->budget = budget ? budget : DEFAULT_BUDGET;
+  c->clock = 0;
+  c->generation = 0;
+  c->in_set = (uint*)calloc(s->nb_cells + 1, sizeof(uint));
+  c->seen = (uint*)calloc(s->nb_cells + 1, sizeof(uint));
+  c->cons_seen = (uint*)calloc(s->nb_cons + 1, sizeof(uint));
+  assert(c->buckets && c->in_set && c->seen && c->cons_seen);
+}
+
+/* ************************************************************************** */
+
+static void _counter_free(counter* c) {
+  for (uint b = 0; b < c->capacity; b++)
+    while (c->buckets[b]) {
+      entry* e = c->buckets[b];
+      c->buckets[b] = e->next;
+      _entry_free(e);
+    }
+  free(c->buckets);
+  free(c->in_set);
+  free(c->seen);
+  free(c->cons_seen);
+}
+
+/* ************************************************************************** */
+
+bigint* cache_count(solver* s, size_t budget) {
+  assert(!s->conflict);
+  counter c;
+  _counter_init(&c, s, budget);
+  uint n = 0;
+  uint* cells = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(cells);
+  for (uint x = 0; x < s->nb_cells; x++)
+    if (s->colors[x] == EMPTY) cells[n++] = x;
+  bigint* count = _count_cells(&c, cells, n);
+  _counter_free(&c);
+  free(cells);
+  return count;
+}
+
+/* ************************************************************************** */
+
+bigint* cache_marginals(solver* s, size_t budget, bigint** black) {
+  assert(!s->conflict);
+  counter c;
+  _counter_init(&c, s, budget);
+  uint n = 0;
+  uint* cells = (uint*)calloc(s->nb_cells + 1, sizeof(uint));
+  bigint** cell_black = (bigint**)malloc((s->nb_cells + 1) * sizeof(bigint*));
+  assert(cells && cell_black);
+  for (uint x = 0; x < s->nb_cells; x++)
+    if (s->colors[x] == EMPTY) cells[n++] = x;
+  bigint* count = _marginals_cells(&c, cells, n, cell_black);
+  for (uint i = 0; i < n; i++) {
+    bigint_add(black[cells[i]], cell_black[i]);
+    bigint_free(cell_black[i]);
+  }
+  for (uint x = 0; x < s->nb_cells; x++)
+    if (s->colors[x] == BLACK) bigint_add(black[x], count);
+  _counter_free(&c);
+  free(cells);
+  free(cell_black);
+  return count;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,610 @@
+/**
+ * @file game_cdcl.c
+ * @brief Conflict-driven clause learning over the cardinality constraints.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* A literal is 2 * x + 1 for "cell x is black", and 2 * x for "cell x is
+ * white". The reason of an assignment is a constraint k >= 0, a learnt clause
+ * c encoded as -2 - c, or REASON_NONE for a decision (and for the conflict
+ * returned by a successful propagation). */
+#define REASON_NONE (-1)
+#define CLAUSE_REASON(c) (-2 - (int)(c))
+
+/* number of conflicts before the first restart, scaled by the Luby sequence */
+#define RESTART_BASE 300
+
+/* activity decay of the cells, at each conflict */
+#define ACTIVITY_DECAY 0.95
+
+/* A learnt clause: one of its literals must hold. The first two literals are
+ * watched. */
+typedef struct {
+  uint size;
+  uint lbd;  // number of distinct decision levels when learnt
+  uint lits[];
+} clause;
+
+/* A growable array. */
+typedef struct {
+  uint* data;
+  uint size, capacity;
+} vec;
+
+/* Learning state. The assignment itself lives in the solver: its trail,
+ * counters and queue are used as they are. */
+typedef struct {
+  solver* s;
+  uint* level;        // cell -> decision level of its assignment
+  int* reason;        // cell -> reason of its assignment
+  uint* pos;          // cell -> position on the trail
+  uint* lim;          // level -> trail size before its decision
+  uint nb_levels;     // current decision level
+  uint qhead;         // next trail position to propagate through the clauses
+  clause** clauses;   // learnt clauses
+  uint nb_clauses, cap_clauses;
+  uint max_clauses;   // clause database size triggering a reduction
+  vec* watches;       // literal -> clauses watching it
+  double* activity;   // cell -> activity
+  double inc;         // current activity increment
+  uint* heap;         // cells by decreasing activity
+  uint heap_size;
+  uint* heap_pos;     // cell -> position in the heap (or UINT32_MAX)
+  color* phase;       // cell -> last color assigned
+  bool* seen;         // cell -> marked during conflict analysis
+  uint* stamp;        // level -> last conflict counting it, for the lbd
+  vec learnt;         // cells of the clause being learnt
+  vec buffer;         // cells of a reason
+} cdcl;
+
+/* ************************************************************************** */
+/*                                  VECTORS                                   */
+/* ************************************************************************** */
+
+static void _push(vec* v, uint x) {
+  if (v->size == v->capacity) {
+    v->capacity = v->capacity ? 2 * v->capacity : 4;
+    v->data = (uint*)realloc(v->data, v->capacity * sizeof(uint));
+    assert(v->data);
+  }
+  v->data[v->size++] = x;
+}
+
+/* ************************************************************************** */
+/*                                    HEAP                                    */
+/* ************************************************************************** */
+
+static void _heap_up(cdcl* cd, uint i) {
+  uint x = cd->heap[i];
+  while (i > 0 && cd->activity[cd->heap[(i - 1) / 2]] < cd->activity[x]) {
+    cd->heap[i] = cd->heap[(i - 1) / 2];
+    cd->heap_pos[cd->heap[i]] = i;
+    i = (i - 1) / 2;
+  }
+  cd->heap[i] = x;
+  cd->heap_pos[x] = i;
+}
+
+/* ************************************************************************** */
+
+static void _heap_down(cdcl* cd, uint i) {
+  uint x = cd->heap[i];
+  while (2 * i + 1 < cd->heap_size) {
+    uint c = 2 * i + 1;
+    if (c + 1 < cd->heap_size &&
+        cd->activity[cd->heap[c + 1]] > cd->activity[cd->heap[c]])
+      c++;
+    if (cd->activity[cd->heap[c]] <= cd->activity[x]) break;
+    cd->heap[i] = cd->heap[c];
+    cd->heap_pos[cd->heap[i]] = i;
+    i = c;
+  }
+  cd->heap[i] = x;
+  cd->heap_pos[x] = i;
+}
+
+/* ************************************************************************** */
+
+static void _heap_insert(cdcl* cd, uint x) {
+  if (cd->heap_pos[x] != UINT32_MAX) return;
+  cd->heap[cd->heap_size] = x;
+  _heap_up(cd, cd->heap_size++);
+}
+
+/* ************************************************************************** */
+
+static uint _heap_pop(cdcl* cd) {
+  uint x = cd->heap[0];
+  cd->heap_pos[x] = UINT32_MAX;
+  if (--cd->heap_size > 0) {
+    cd->heap[0] = cd->heap[cd->heap_size];
+    _heap_down(cd, 0);
+  }
+  return x;
+}
+
+/* ************************************************************************** */
+
+/* Bumps the activity of a cell, rescaling all of them if needed. */
+static void _bump(cdcl* cd, uint x) {
+  if ((cd->activity[x] += cd->inc) > 1e100) {
+    for (uint y = 0; y < cd->s->nb_cells; y++) cd->activity[y] *= 1e-100;
+    cd->inc *= 1e-100;
+  }
+  if (cd->heap_pos[x] != UINT32_MAX) _heap_up(cd, cd->heap_pos[x]);
+}
+
+/* ************************************************************************** */
+/*                                ASSIGNMENTS                                 */
+/* ************************************************************************** */
+
+/* Returns 1 if the literal holds, -1 if it is false, 0 if undecided. */
+static int _value(const solver* s, uint l) {
+  color c = s->colors[l / 2];
+  if (c == EMPTY) return 0;
+  return ((c == BLACK) == (l & 1)) ? 1 : -1;
+}
+
+/* ************************************************************************** */
+
+static void _assign(cdcl* cd, uint x, color c, int reason) {
+  cd->pos[x] = cd->s->trail_size;
+  cd->level[x] = cd->nb_levels;
+  cd->reason[x] = reason;
+  solver_assign(cd->s, x, c);  // a violated constraint is queued, and found
+}
+
+/* ************************************************************************** */
+
+/* Undoes the assignments of the levels above a given one. */
+static void _backjump(cdcl* cd, uint level) {
+  if (cd->nb_levels <= level) return;
+  solver* s = cd->s;
+  uint mark = cd->lim[level + 1];
+  for (uint i = mark; i < s->trail_size; i++) {
+    uint x = s->trail[i];
+    cd->phase[x] = s->colors[x];
+    _heap_insert(cd, x);
+  }
+  solver_undo(s, mark);
+  cd->qhead = mark;
+  cd->nb_levels = level;
+}
+
+/* ************************************************************************** */
+
+/* Propagates the queued constraints, then the learnt clauses watching the
+ * literals falsified by the new assignments. Returns the reason of the
+ * conflict, or REASON_NONE. */
+static int _propagate(cdcl* cd) {
+  solver* s = cd->s;
+  while (true) {
+    while (s->queue_size > 0) {
+      uint k = s->queue[--s->queue_size];
+      s->queued[k] = false;
+      int need = s->cons_need[k];
+      if (s->cons_black[k] > need || s->cons_black[k] + s->cons_empty[k] < need)
+        return k;
+      if (s->cons_empty[k] == 0) continue;
+      for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+        uint x = s->cons_cells[p];
+        if (s->colors[x] != EMPTY) continue;
+        int w = s->cons_weights[p];
+        if (s->cons_black[k] + w > need)
+          _assign(cd, x, WHITE, k);
+        else if (s->cons_black[k] + s->cons_empty[k] - w < need)
+          _assign(cd, x, BLACK, k);
+      }
+    }
+    if (cd->qhead == s->trail_size) return REASON_NONE;
+
+    uint x = s->trail[cd->qhead++];
+    uint f = 2 * x + (s->colors[x] == WHITE);  // the falsified literal
+    vec* w = &cd->watches[f];
+    uint i = 0, j = 0;
+    while (i < w->size) {
+      uint ci = w->data[i++];
+      clause* c = cd->clauses[ci];
+      if (c->lits[0] == f) {
+        c->lits[0] = c->lits[1];
+        c->lits[1] = f;
+      }
+      if (_value(s, c->lits[0]) > 0) {
+        w->data[j++] = ci;
+        continue;
+      }
+      // look for another literal to watch
+      bool moved = false;
+      for (uint t = 2; t < c->size && !moved; t++)
+        if (_value(s, c->lits[t]) >= 0) {
+          c->lits[1] = c->lits[t];
+          c->lits[t] = f;
+          _push(&cd->watches[c->lits[1]], ci);
+          moved = true;
+        }
+      if (moved) continue;
+      w->data[j++] = ci;
+      if (_value(s, c->lits[0]) < 0) {  // all the literals are false
+        while (i < w->size) w->data[j++] = w->data[i++];
+        w->size = j;
+        return CLAUSE_REASON(ci);
+      }
+      uint l = c->lits[0];
+      _assign(cd, l / 2, (l & 1) ? BLACK : WHITE, CLAUSE_REASON(ci));
+    }
+    w->size = j;
+  }
+}
+
+/* ************************************************************************** */
+/*                                  LEARNING                                  */
+/* ************************************************************************** */
+
+/* Collects in cd->buffer the cells whose colors caused a conflict (x ==
+ * nb_cells) or the assignment of cell x. For a constraint, these are its
+ * black cells if it has too many of them (or if it forced x white), and its
+ * white cells otherwise, assigned before x. */
+static void _reason(cdcl* cd, int reason, uint x) {
+  solver* s = cd->s;
+  cd->buffer.size = 0;
+  if (reason < REASON_NONE) {
+    clause* c = cd->clauses[-2 - reason];
+    for (uint t = 0; t < c->size; t++)
+      if (c->lits[t] / 2 != x) _push(&cd->buffer, c->lits[t] / 2);
+    return;
+  }
+  uint k = reason;
+  color col;
+  if (x == s->nb_cells)
+    col = (s->cons_black[k] > s->cons_need[k]) ? BLACK : WHITE;
+  else
+    col = (s->colors[x] == WHITE) ? BLACK : WHITE;
+  for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+    uint y = s->cons_cells[p];
+    if (y != x && s->colors[y] == col &&
+        (x == s->nb_cells || cd->pos[y] < cd->pos[x]))
+      _push(&cd->buffer, y);
+  }
+}
+
+/* ************************************************************************** */
+
+/* Tests if a cell of the learnt clause is implied by the other ones. */
+static bool _redundant(cdcl* cd, uint x) {
+  if (cd->reason[x] == REASON_NONE) return false;
+  _reason(cd, cd->reason[x], x);
+  for (uint t = 0; t < cd->buffer.size; t++) {
+    uint y = cd->buffer.data[t];
+    if (!cd->seen[y] && cd->level[y] > 0) return false;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* First-UIP conflict analysis: the cells of the learnt clause are put in
+ * cd->learnt, the one of the current level first, then one of the level to
+ * backjump to. Returns this level. */
+static uint _analyze(cdcl* cd, int confl) {
+  solver* s = cd->s;
+  vec* learnt = &cd->learnt;
+  learnt->size = 0;
+  _push(learnt, s->nb_cells);  // room for the UIP
+
+  uint path = 0, x = s->nb_cells, idx = s->trail_size;
+  do {
+    _reason(cd, confl, x);
+    for (uint t = 0; t < cd->buffer.size; t++) {
+      uint y = cd->buffer.data[t];
+      if (cd->seen[y] || cd->level[y] == 0) continue;
+      cd->seen[y] = true;
+      _bump(cd, y);
+      if (cd->level[y] == cd->nb_levels)
+        path++;
+      else
+        _push(learnt, y);
+    }
+    do x = s->trail[--idx];
+    while (!cd->seen[x]);
+    cd->seen[x] = false;
+    confl = cd->reason[x];
+  } while (--path > 0);
+  learnt->data[0] = x;
+
+  // drop the cells implied by the other ones
+  uint n = 1;
+  for (uint t = 1; t < learnt->size; t++)
+    if (!_redundant(cd, learnt->data[t])) {
+      uint tmp = learnt->data[n];
+      learnt->data[n++] = learnt->data[t];
+      learnt->data[t] = tmp;  // the dropped cells move to the end
+    }
+  for (uint t = 1; t < learnt->size; t++) cd->seen[learnt->data[t]] = false;
+  learnt->size = n;
+
+  uint back = 0;
+  for (uint t = 1; t < n; t++)
+    if (cd->level[learnt->data[t]] > back) {
+      back = cd->level[learnt->data[t]];
+      uint tmp = learnt->data[1];
+      learnt->data[1] = learnt->data[t];
+      learnt->data[t] = tmp;
+    }
+  return back;
+}
+
+/* ************************************************************************** */
+
+/* Learns the clause of cd->learnt, after the backjump: its first cell gets
+ * the other color. */
+static void _learn(cdcl* cd, uint conflicts) {
+  solver* s = cd->s;
+  vec* learnt = &cd->learnt;
+  uint x = learnt->data[0];
+  color c = (s->colors[x] == WHITE) ? BLACK : WHITE;
+  uint n = learnt->size;
+  if (n == 1) {
+    _backjump(cd, 0);
+    _assign(cd, x, c, REASON_NONE);
+    return;
+  }
+
+  clause* cl = (clause*)malloc(sizeof(clause) + n * sizeof(uint));
+  assert(cl);
+  cl->size = n;
+  cl->lbd = 0;
+  for (uint t = 0; t < n; t++) {
+    uint y = learnt->data[t];
+    cl->lits[t] = 2 * y + (s->colors[y] == WHITE);  // the other color
+    if (cd->stamp[cd->level[y]] != conflicts) {
+      cd->stamp[cd->level[y]] = conflicts;
+      cl->lbd++;
+    }
+  }
+  if (cd->nb_clauses == cd->cap_clauses) {
+    cd->cap_clauses = cd->cap_clauses ? 2 * cd->cap_clauses : 64;
+    cd->clauses =
+        (clause**)realloc(cd->clauses, cd->cap_clauses * sizeof(clause*));
+    assert(cd->clauses);
+  }
+  uint ci = cd->nb_clauses++;
+  cd->clauses[ci] = cl;
+  _push(&cd->watches[cl->lits[0]], ci);
+  _push(&cd->watches[cl->lits[1]], ci);
+
+  _backjump(cd, cd->level[learnt->data[1]]);
+  _assign(cd, x, c, CLAUSE_REASON(ci));
+}
+
+/* ************************************************************************** */
+
+static int _cmp_clauses(const void* a, const void* b) {
+  const clause* c = *(clause* const*)a;
+  const clause* d = *(clause* const*)b;
+  if (c->lbd != d->lbd) return (c->lbd > d->lbd) - (c->lbd < d->lbd);
+  return (c->size > d->size) - (c->size < d->size);
+}
+
+/* ************************************************************************** */
+
+/* At level 0, after a restart: keeps the best half of the clauses (with the
+ * lowest lbd), removes their literals false at level 0 and the clauses
+ * already satisfied, and rebuilds the watches. The reasons of the level 0
+ * assignments become stale, but they are never analyzed. */
+static void _reduce(cdcl* cd) {
+  solver* s = cd->s;
+  assert(cd->nb_levels == 0);
+  qsort(cd->clauses, cd->nb_clauses, sizeof(clause*), _cmp_clauses);
+  uint n = 0;
+  for (uint i = 0; i < cd->nb_clauses; i++) {
+    clause* c = cd->clauses[i];
+    bool keep = (i < cd->nb_clauses / 2 || c->lbd <= 2);
+    uint size = 0;
+    for (uint t = 0; t < c->size && keep; t++) {
+      int v = _value(s, c->lits[t]);
+      if (v > 0) keep = false;
+      if (v == 0) c->lits[size++] = c->lits[t];
+    }
+    if (!keep) {
+      free(c);
+      continue;
+    }
+    assert(size >= 2);  // the level 0 is fully propagated
+    c->size = size;
+    cd->clauses[n++] = c;
+  }
+  cd->nb_clauses = n;
+
+  for (uint l = 0; l < 2 * s->nb_cells; l++) cd->watches[l].size = 0;
+  for (uint i = 0; i < n; i++) {
+    _push(&cd->watches[cd->clauses[i]->lits[0]], i);
+    _push(&cd->watches[cd->clauses[i]->lits[1]], i);
+  }
+}
+
+/* ************************************************************************** */
+/*                               CDCL ENGINE                                  */
+/* ************************************************************************** */
+
+static void _cdcl_init(cdcl* cd, solver* s) {
+  memset(cd, 0, sizeof(cdcl));
+  cd->s = s;
+  uint n = s->nb_cells;
+  cd->level = (uint*)calloc(n + 1, sizeof(uint));
+  cd->reason = (int*)malloc((n + 1) * sizeof(int));
+  cd->pos = (uint*)calloc(n + 1, sizeof(uint));
+  cd->lim = (uint*)malloc((n + 2) * sizeof(uint));
+  cd->watches = (vec*)calloc(2 * n + 1, sizeof(vec));
+  cd->activity = (double*)malloc((n + 1) * sizeof(double));
+  cd->heap = (uint*)malloc((n + 1) * sizeof(uint));
+  cd->heap_pos = (uint*)malloc((n + 1) * sizeof(uint));
+  cd->phase = (color*)malloc((n + 1) * sizeof(color));
+  cd->seen = (bool*)calloc(n + 1, sizeof(bool));
+  cd->stamp = (uint*)calloc(n + 2, sizeof(uint));
+  assert(cd->level && cd->reason && cd->pos && cd->lim && cd->watches &&
+         cd->activity && cd->heap && cd->heap_pos && cd->phase && cd->seen &&
+         cd->stamp);
+  cd->inc = 1;
+  cd->max_clauses = s->nb_cons / 3 + 2000;
+  cd->qhead = s->trail_size;
+
+  // the cells covered by more constraints are decided first
+  for (uint x = 0; x < n; x++) {
+    cd->reason[x] = REASON_NONE;
+    cd->activity[x] = s->cell_start[x + 1] - s->cell_start[x];
+    cd->heap_pos[x] = UINT32_MAX;
+    cd->phase[x] = WHITE;
+    if (s->colors[x] == EMPTY && !solver_is_free(s, x)) _heap_insert(cd, x);
+  }
+}
+
+/* ************************************************************************** */
+
+static void _cdcl_free(cdcl* cd) {
+  for (uint i = 0; i < cd->nb_clauses; i++) free(cd->clauses[i]);
+  for (uint l = 0; l < 2 * cd->s->nb_cells; l++) free(cd->watches[l].data);
+  free(cd->clauses);
+  free(cd->watches);
+  free(cd->level);
+  free(cd->reason);
+  free(cd->pos);
+  free(cd->lim);
+  free(cd->activity);
+  free(cd->heap);
+  free(cd->heap_pos);
+  free(cd->phase);
+  free(cd->seen);
+  free(cd->stamp);
+  free(cd->learnt.data);
+  free(cd->buffer.data);
+}
+
+/* ************************************************************************** */
+
+/* Searches a solution extending the assumptions (literals), decided first in
+ * order, one level each. Returns 1 if a solution is found (kept as the
+ * assignment), 0 if there is no solution at all, and -1 if there is none with
+ * the assumptions. The learnt clauses are kept for the next calls. */
+static int _run(cdcl* cd, const uint* assumps, uint nb_assumps) {
+  solver* s = cd->s;
+  uint64_t restarts = 0, conflicts = 0;
+  uint64_t limit = RESTART_BASE * solver_luby(0);
+
+  while (true) {
+    int confl = _propagate(cd);
+    if (confl != REASON_NONE) {
+      s->nb_conflicts++;
+      conflicts++;
+      if (cd->nb_levels == 0) return 0;  // no solution
+      _analyze(cd, confl);
+      _learn(cd, (uint)s->nb_conflicts);
+      cd->inc /= ACTIVITY_DECAY;
+      continue;
+    }
+
+    if (conflicts >= limit) {
+      _backjump(cd, 0);
+      conflicts = 0;
+      limit = RESTART_BASE * solver_luby(++restarts);
+      if (cd->nb_clauses >= cd->max_clauses) {
+        _reduce(cd);
+        cd->max_clauses += cd->max_clauses / 10;
+      }
+      continue;
+    }
+
+    // the assumptions first, an assumption already true taking an empty level
+    if (cd->nb_levels < nb_assumps) {
+      uint l = assumps[cd->nb_levels];
+      int v = _value(s, l);
+      if (v < 0) return -1;
+      cd->lim[++cd->nb_levels] = s->trail_size;
+      if (v == 0) _assign(cd, l / 2, (l & 1) ? BLACK : WHITE, REASON_NONE);
+      continue;
+    }
+
+    // decide the most active empty cell, with its last color
+    uint x = s->nb_cells;
+    while (cd->heap_size > 0 && x == s->nb_cells) {
+      uint y = _heap_pop(cd);
+      if (s->colors[y] == EMPTY) x = y;
+    }
+    if (x == s->nb_cells) return 1;
+    s->nb_nodes++;
+    cd->lim[++cd->nb_levels] = s->trail_size;
+    _assign(cd, x, cd->phase[x], REASON_NONE);
+  }
+}
+
+/* ************************************************************************** */
+
+bool cdcl_solve(solver* s) {
+  if (s->conflict) return false;
+  cdcl cd;
+  _cdcl_init(&cd, s);
+  uint mark = solver_mark(s);
+  bool found = _run(&cd, NULL, 0) > 0;
+
+  if (found) {
+    for (uint x = 0; x < s->nb_cells; x++)
+      if (s->colors[x] == EMPTY) solver_assign(s, x, WHITE);  // free cells
+  } else {
+    solver_undo(s, mark);
+  }
+  solver_undo(s, solver_mark(s));  // clears the queues
+  _cdcl_free(&cd);
+  return found;
+}
+
+/* ************************************************************************** */
+
+bool cdcl_backbone(solver* s, color* fixed) {
+  cdcl cd;
+  _cdcl_init(&cd, s);
+  uint mark = solver_mark(s);
+  bool found = !s->conflict && _run(&cd, NULL, 0) > 0;
+
+  // the candidates are the colors of the first solution, and each one is
+  // dropped by a solution with the other color
+  for (uint x = 0; x < s->nb_cells; x++)
+    fixed[x] = (found && !solver_is_free(s, x)) ? s->colors[x] : EMPTY;
+  for (uint x = 0; x < s->nb_cells && found; x++) {
+    if (fixed[x] == EMPTY) continue;
+    _backjump(&cd, 0);
+    if (s->colors[x] != EMPTY) continue;  // fixed at level 0
+    // the other colors of the candidates are tried first, so that the next
+    // solution drops as many of them as possible
+    for (uint y = x; y < s->nb_cells; y++)
+      if (fixed[y] != EMPTY) cd.phase[y] = (fixed[y] == WHITE) ? BLACK : WHITE;
+    uint l = 2 * x + (fixed[x] == WHITE);  // the other color
+    int r = _run(&cd, &l, 1);
+    assert(r != 0);
+    if (r > 0) {
+      for (uint y = x; y < s->nb_cells; y++)
+        if (fixed[y] != EMPTY && s->colors[y] != fixed[y]) fixed[y] = EMPTY;
+    } else {
+      _backjump(&cd, 0);
+      if (s->colors[x] == EMPTY) _assign(&cd, x, fixed[x], REASON_NONE);
+    }
+  }
+
+  _backjump(&cd, 0);
+  solver_undo(s, mark);
+  _cdcl_free(&cd);
+  return found;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,233 @@
+/**
+ * @file game_classes.c
+ * @brief Counting solutions over classes of interchangeable cells.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bigint.h"
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* the engine is used if it divides the number of cells at least by this */
+#define MIN_COMPRESSION 2
+
+/* A class is a set of empty cells covered by exactly the same constraints,
+ * with the same weights: only its number of black cells matters. */
+typedef struct {
+  uint nb_classes;
+  uint* size;    // number of cells in each class
+  uint* start;   // constraints of class c: cons[start[c]..start[c+1]-1]
+  uint* cons;    // constraints covering the class
+  int* weights;  // weight of the class cells in each constraint
+  int* need;     // black cells still needed by each constraint
+  int* room;     // weighted number of cells still undecided
+} classes;
+
+/* ************************************************************************** */
+/*                                 CLASSES                                    */
+/* ************************************************************************** */
+
+/* Tests if two cells are covered by the same constraints, with the same
+ * weights. */
+static bool _same_class(const solver* s, uint x, uint y) {
+  uint n = s->cell_start[x + 1] - s->cell_start[x];
+  return n == s->cell_start[y + 1] - s->cell_start[y] &&
+         !memcmp(s->cell_cons + s->cell_start[x],
+                 s->cell_cons + s->cell_start[y], n * sizeof(uint)) &&
+         !memcmp(s->cell_weights + s->cell_start[x],
+                 s->cell_weights + s->cell_start[y], n * sizeof(uint));
+}
+
+/* ************************************************************************** */
+
+/* Groups the empty constrained cells of the solver into classes. Returns
+ * false (and builds nothing) if the compression is too weak. */
+static bool _classes_init(classes* c, const solver* s) {
+  // the cells of a class share their first constraint (the constraints of a
+  // cell are sorted), so classes are searched in the neighbourhood of the
+  // first constraint of their cells only
+  uint* rep = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  uint* size = (uint*)calloc(s->nb_cells + 1, sizeof(uint));
+  assert(rep && size);
+  uint nb_cells = 0, nb_classes = 0, nb_entries = 0;
+  for (uint k = 0; k < s->nb_cons; k++)
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] != EMPTY || s->cell_cons[s->cell_start[x]] != k)
+        continue;
+      nb_cells++;
+      rep[x] = x;
+      for (uint q = s->cons_start[k]; q < p; q++) {
+        uint y = s->cons_cells[q];
+        if (s->colors[y] == EMPTY && _same_class(s, x, y) && rep[y] == y) {
+          rep[x] = y;
+          break;
+        }
+      }
+      if (rep[x] == x) {
+        nb_classes++;
+        nb_entries += s->cell_start[x + 1] - s->cell_start[x];
+      }
+      size[rep[x]]++;
+    }
+
+  if (nb_classes * MIN_COMPRESSION > nb_cells) {
+    free(rep);
+    free(size);
+    return false;
+  }
+
+  c->nb_classes = nb_classes;
+  c->size = (uint*)malloc((nb_classes + 1) * sizeof(uint));
+  c->start = (uint*)malloc((nb_classes + 1) * sizeof(uint));
+  c->cons = (uint*)malloc((nb_entries + 1) * sizeof(uint));
+  c->weights = (int*)malloc((nb_entries + 1) * sizeof(int));
+  c->need = (int*)malloc((s->nb_cons + 1) * sizeof(int));
+  c->room = (int*)malloc((s->nb_cons + 1) * sizeof(int));
+  assert(c->size && c->start && c->cons && c->weights && c->need && c->room);
+
+  // classes in the order of their first constraint, to close them early
+  uint l = 0, e = 0;
+  for (uint k = 0; k < s->nb_cons; k++)
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] != EMPTY || s->cell_cons[s->cell_start[x]] != k ||
+          rep[x] != x)
+        continue;
+      c->size[l] = size[x];
+      c->start[l++] = e;
+      for (uint q = s->cell_start[x]; q < s->cell_start[x + 1]; q++) {
+        c->cons[e] = s->cell_cons[q];
+        c->weights[e++] = s->cell_weights[q];
+      }
+    }
+  c->start[nb_classes] = e;
+  for (uint k = 0; k < s->nb_cons; k++) {
+    c->need[k] = s->cons_need[k] - s->cons_black[k];
+    c->room[k] = s->cons_empty[k];
+  }
+
+  free(rep);
+  free(size);
+  return true;
+}
+
+/* ************************************************************************** */
+
+static void _classes_free(classes* c) {
+  free(c->size);
+  free(c->start);
+  free(c->cons);
+  free(c->weights);
+  free(c->need);
+  free(c->room);
+}
+
+/* ************************************************************************** */
+
+/* Computes the range of black cells allowed in class k by its constraints. */
+static void _range(const classes* c, uint k, int* lo, int* hi) {
+  int n = c->size[k];
+  *lo = 0;
+  *hi = n;
+  for (uint p = c->start[k]; p < c->start[k + 1]; p++) {
+    int need = c->need[c->cons[p]], room = c->room[c->cons[p]];
+    int w = c->weights[p];
+    // w * b <= need, and need - w * b <= room - w * n
+    int up = need / w;
+    int down = need - room + w * n;
+    down = (down > 0) ? (down + w - 1) / w : 0;
+    if (up < *hi) *hi = up;
+    if (down > *lo) *lo = down;
+  }
+}
+
+/* ************************************************************************** */
+
+/* Sets b black cells in class k (or removes them if sign is -1). */
+static void _apply(classes* c, uint k, int b, int sign) {
+  for (uint p = c->start[k]; p < c->start[k + 1]; p++) {
+    c->need[c->cons[p]] -= sign * c->weights[p] * b;
+    c->room[c->cons[p]] -= sign * c->weights[p] * (int)c->size[k];
+  }
+}
+
+/* ************************************************************************** */
+
+static uint32_t _binomial(uint n, uint k) {
+  uint64_t r = 1;
+  for (uint i = 1; i <= k; i++) r = r * (n - k + i) / i;
+  return (uint32_t)r;
+}
+
+/* ************************************************************************** */
+/*                               CLASS ENGINE                                 */
+/* ************************************************************************** */
+
+bigint* classes_count(solver* s) {
+  assert(!s->conflict);
+  classes c;
+  if (!_classes_init(&c, s)) return NULL;
+
+  // depth-first search over the number of black cells of each class, with
+  // the product of the binomials along the path
+  uint n = c.nb_classes;
+  int* b = (int*)malloc((n + 1) * sizeof(int));
+  int* hi = (int*)malloc((n + 1) * sizeof(int));
+  bigint** prod = (bigint**)malloc((n + 1) * sizeof(bigint*));
+  assert(b && hi && prod);
+  for (uint k = 0; k <= n; k++) prod[k] = bigint_new(1);
+  bigint* count = bigint_new(0);
+
+  uint d = 0;
+  bool down = true;
+  while (true) {
+    if (down) {
+      if (d == n) {
+        bigint_add(count, prod[n]);
+        down = false;
+        continue;
+      }
+      int lo;
+      _range(&c, d, &lo, &hi[d]);
+      if (lo > hi[d]) {
+        down = false;
+        continue;
+      }
+      b[d] = lo;
+    } else {
+      // next value of the last class
+      if (d == 0) break;
+      d--;
+      _apply(&c, d, b[d], -1);
+      if (++b[d] > hi[d]) continue;
+      down = true;
+    }
+    _apply(&c, d, b[d], 1);
+    bigint_set(prod[d + 1], prod[d]);
+    bigint_mul_u32(prod[d + 1], _binomial(c.size[d], b[d]));
+    d++;
+  }
+
+  // each free cell doubles the count
+  bigint_shl(count, s->nb_free_empty);
+
+  for (uint k = 0; k <= n; k++) bigint_free(prod[k]);
+  free(prod);
+  free(b);
+  free(hi);
+  _classes_free(&c);
+  return count;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,418 @@
+/**
+ * @file game_diagram.c
+ * @brief Compiled solution sets, as zero-suppressed decision diagrams.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include "game_diagram.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bigint.h"
+#include "game.h"
+#include "game_private.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* initial number of nodes of a store */
+#define INIT_NODES 64
+
+struct diagram_s {
+  uint nb_rows, nb_cols;
+  uint* order;      // position (variable) -> square, row-major
+  zdd z;            // nodes
+  bigint** counts;  // if not NULL, number of solutions below each node
+  double* p_black;  // if not NULL, probability of the black child of each
+                    // node in a uniform solution
+};
+
+/* ************************************************************************** */
+/*                              NODE STORE                                    */
+/* ************************************************************************** */
+
+static inline uint _hash(uint var, uint lo, uint hi, uint size) {
+  uint64_t key = ((uint64_t)var << 40) ^ ((uint64_t)lo << 20) ^ hi;
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return (uint)(key & (size - 1));
+}
+
+/* ************************************************************************** */
+
+void zdd_init(zdd* z, uint nb_vars) {
+  z->nb_vars = nb_vars;
+  z->nb_nodes = 2;
+  z->capacity = INIT_NODES;
+  z->var = (uint*)malloc(z->capacity * sizeof(uint));
+  z->lo = (uint*)malloc(z->capacity * sizeof(uint));
+  z->hi = (uint*)malloc(z->capacity * sizeof(uint));
+  z->table_size = 2 * INIT_NODES;
+  z->table = (uint*)calloc(z->table_size, sizeof(uint));
+  assert(z->var && z->lo && z->hi && z->table);
+  for (uint k = ZDD_FALSE; k <= ZDD_TRUE; k++) {
+    z->var[k] = nb_vars;
+    z->lo[k] = k;
+    z->hi[k] = k;
+  }
+  z->root = ZDD_FALSE;
+}
+
+/* ************************************************************************** */
+
+void zdd_free(zdd* z) {
+  free(z->var);
+  free(z->lo);
+  free(z->hi);
+  free(z->table);
+  z->var = z->lo = z->hi = z->table = NULL;
+}
+
+/* ************************************************************************** */
+
+/* Doubles the unique table and inserts the nodes again. */
+static void _rehash(zdd* z) {
+  free(z->table);
+  z->table_size *= 2;
+  z->table = (uint*)calloc(z->table_size, sizeof(uint));
+  assert(z->table);
+  for (uint k = ZDD_TRUE + 1; k < z->nb_nodes; k++) {
+    uint h = _hash(z->var[k], z->lo[k], z->hi[k], z->table_size);
+    while (z->table[h] != 0) h = (h + 1) & (z->table_size - 1);
+    z->table[h] = k;
+  }
+}
+
+/* ************************************************************************** */
+
+uint zdd_node(zdd* z, uint var, uint lo, uint hi) {
+  if (hi == ZDD_FALSE) return lo;
+  assert(var < z->var[lo] && var < z->var[hi]);
+  uint h = _hash(var, lo, hi, z->table_size);
+  while (z->table[h] != 0) {
+    uint k = z->table[h];
+    if (z->var[k] == var && z->lo[k] == lo && z->hi[k] == hi) return k;
+    h = (h + 1) & (z->table_size - 1);
+  }
+
+  if (z->nb_nodes == z->capacity) {
+    z->capacity *= 2;
+    z->var = (uint*)realloc(z->var, z->capacity * sizeof(uint));
+    z->lo = (uint*)realloc(z->lo, z->capacity * sizeof(uint));
+    z->hi = (uint*)realloc(z->hi, z->capacity * sizeof(uint));
+    assert(z->var && z->lo && z->hi);
+  }
+  uint k = z->nb_nodes++;
+  z->var[k] = var;
+  z->lo[k] = lo;
+  z->hi[k] = hi;
+  z->table[h] = k;
+  if (2 * z->nb_nodes > z->table_size) _rehash(z);
+  return k;
+}
+
+/* ************************************************************************** */
+/*                               DIAGRAMS                                     */
+/* ************************************************************************** */
+
+static diagram _new(uint nb_rows, uint nb_cols) {
+  diagram d = (diagram)malloc(sizeof(struct diagram_s));
+  assert(d);
+  d->nb_rows = nb_rows;
+  d->nb_cols = nb_cols;
+  d->order = (uint*)malloc((nb_rows * nb_cols + 1) * sizeof(uint));
+  assert(d->order);
+  for (uint x = 0; x < nb_rows * nb_cols; x++) d->order[x] = x;
+  zdd_init(&d->z, nb_rows * nb_cols);
+  d->counts = NULL;
+  d->p_black = NULL;
+  return d;
+}
+
+/* ************************************************************************** */
+
+diagram diagram_compile(cgame g) {
+  solver* s = solver_new(g, false, PROPAGATION_DEFAULT);
+  diagram d = _new(s->nb_rows, s->nb_cols);
+  bigint* nb = NULL;
+  if (s->conflict)
+    nb = bigint_new(0);
+  else if (MIN(s->nb_rows, s->nb_cols) <= ROWDP_MAX_WIDTH)
+    nb = rowdp_compile(s, &d->z, d->order);
+  solver_delete(s);
+  if (nb == NULL) {
+    diagram_delete(d);
+    return NULL;
+  }
+  bigint_free(nb);
+  return d;
+}
+
+/* ************************************************************************** */
+
+void diagram_delete(diagram d) {
+  if (d == NULL) return;
+  if (d->counts)
+    for (uint k = 0; k < d->z.nb_nodes; k++) bigint_free(d->counts[k]);
+  free(d->counts);
+  free(d->p_black);
+  zdd_free(&d->z);
+  free(d->order);
+  free(d);
+}
+
+/* ************************************************************************** */
+
+uint diagram_nb_nodes(diagram d) { return d->z.nb_nodes; }
+
+/* ************************************************************************** */
+/*                                QUERIES                                     */
+/* ************************************************************************** */
+
+/* Counts the solutions below each node, children first. */
+static void _counts(diagram d) {
+  if (d->counts) return;
+  const zdd* z = &d->z;
+  d->counts = (bigint**)malloc(z->nb_nodes * sizeof(bigint*));
+  assert(d->counts);
+  d->counts[ZDD_FALSE] = bigint_new(0);
+  d->counts[ZDD_TRUE] = bigint_new(1);
+  for (uint k = ZDD_TRUE + 1; k < z->nb_nodes; k++) {
+    d->counts[k] = bigint_copy(d->counts[z->lo[k]]);
+    bigint_add(d->counts[k], d->counts[z->hi[k]]);
+  }
+}
+
+/* ************************************************************************** */
+
+bigint* diagram_nb_solutions(diagram d) {
+  _counts(d);
+  return bigint_copy(d->counts[d->z.root]);
+}
+
+/* ************************************************************************** */
+
+bool diagram_is_unique(diagram d) {
+  const zdd* z = &d->z;
+  unsigned char* nb = (unsigned char*)malloc(z->nb_nodes);
+  assert(nb);
+  nb[ZDD_FALSE] = 0;
+  nb[ZDD_TRUE] = 1;
+  for (uint k = ZDD_TRUE + 1; k < z->nb_nodes; k++)
+    nb[k] = MIN(nb[z->lo[k]] + nb[z->hi[k]], 2);
+  bool unique = nb[z->root] == 1;
+  free(nb);
+  return unique;
+}
+
+/* ************************************************************************** */
+
+bool diagram_backbone(diagram d, color* fixed) {
+  const zdd* z = &d->z;
+  uint n = z->nb_vars;
+  for (uint x = 0; x < n; x++) fixed[x] = EMPTY;
+  if (z->root == ZDD_FALSE) return false;
+
+  // nodes on a path from the root, parents first; an edge skipping positions
+  // adds one over them to the difference array skip
+  bool* reached = (bool*)calloc(z->nb_nodes, sizeof(bool));
+  bool* can_black = (bool*)calloc(n + 1, sizeof(bool));
+  bool* can_white = (bool*)calloc(n + 1, sizeof(bool));
+  int* skip = (int*)calloc(n + 2, sizeof(int));
+  assert(reached && can_black && can_white && skip);
+  reached[z->root] = true;
+  skip[0]++;
+  skip[z->var[z->root]]--;
+  for (uint k = z->root; k > ZDD_TRUE; k--) {
+    if (!reached[k]) continue;
+    uint v = z->var[k];
+    can_black[v] = true;
+    if (z->lo[k] != ZDD_FALSE) can_white[v] = true;
+    for (uint b = 0; b <= 1; b++) {
+      uint child = b ? z->hi[k] : z->lo[k];
+      if (child == ZDD_FALSE) continue;
+      reached[child] = true;
+      skip[v + 1]++;
+      skip[z->var[child]]--;
+    }
+  }
+
+  int skipped = 0;
+  for (uint p = 0; p < n; p++) {
+    skipped += skip[p];
+    if (skipped > 0) can_white[p] = true;
+    if (can_black[p] != can_white[p])
+      fixed[d->order[p]] = can_black[p] ? BLACK : WHITE;
+  }
+  free(reached);
+  free(can_black);
+  free(can_white);
+  free(skip);
+  return true;
+}
+
+/* ************************************************************************** */
+
+bool diagram_solution(diagram d, const bigint* k, game g) {
+  assert(game_nb_rows(g) == d->nb_rows && game_nb_cols(g) == d->nb_cols);
+  _counts(d);
+  const zdd* z = &d->z;
+  if (bigint_cmp(k, d->counts[z->root]) >= 0) return false;
+
+  for (uint x = 0; x < d->nb_rows * d->nb_cols; x++)
+    game_set_color(g, x / d->nb_cols, x % d->nb_cols, WHITE);
+  bigint* rest = bigint_copy(k);
+  for (uint u = z->root; u != ZDD_TRUE;) {
+    const bigint* nb_white = d->counts[z->lo[u]];
+    if (bigint_cmp(rest, nb_white) < 0) {
+      u = z->lo[u];
+    } else {
+      bigint_sub(rest, nb_white);
+      uint x = d->order[z->var[u]];
+      game_set_color(g, x / d->nb_cols, x % d->nb_cols, BLACK);
+      u = z->hi[u];
+    }
+  }
+  bigint_free(rest);
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Computes the probability of the black child of each node, from the base-2
+ * logarithms of the counts (which do not overflow, unlike their ratios). */
+static void _probabilities(diagram d) {
+  if (d->p_black) return;
+  const zdd* z = &d->z;
+  double* log2_count = (double*)malloc(z->nb_nodes * sizeof(double));
+  d->p_black = (double*)malloc(z->nb_nodes * sizeof(double));
+  assert(log2_count && d->p_black);
+  log2_count[ZDD_FALSE] = -INFINITY;
+  log2_count[ZDD_TRUE] = 0.0;
+  d->p_black[ZDD_FALSE] = d->p_black[ZDD_TRUE] = 0.0;
+  for (uint k = ZDD_TRUE + 1; k < z->nb_nodes; k++) {
+    double lo = log2_count[z->lo[k]], hi = log2_count[z->hi[k]];
+    double max = MAX(lo, hi), min = MIN(lo, hi);
+    log2_count[k] = max + log2(1.0 + exp2(min - max));
+    d->p_black[k] = exp2(hi - log2_count[k]);
+  }
+  free(log2_count);
+}
+
+/* ************************************************************************** */
+
+/* Draws a number uniformly in [0, 1) from two calls to rand(). */
+static double _uniform(void) {
+  const double range = (double)RAND_MAX + 1.0;
+  return (rand() + rand() / range) / range;
+}
+
+/* ************************************************************************** */
+
+bool diagram_sample_colors(diagram d, color* colors) {
+  const zdd* z = &d->z;
+  if (z->root == ZDD_FALSE) return false;
+  _probabilities(d);
+  for (uint x = 0; x < z->nb_vars; x++) colors[x] = WHITE;
+  for (uint u = z->root; u != ZDD_TRUE;) {
+    if (_uniform() < d->p_black[u]) {
+      colors[d->order[z->var[u]]] = BLACK;
+      u = z->hi[u];
+    } else {
+      u = z->lo[u];
+    }
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+bool diagram_sample(diagram d, game g) {
+  assert(game_nb_rows(g) == d->nb_rows && game_nb_cols(g) == d->nb_cols);
+  color* colors = (color*)malloc((d->z.nb_vars + 1) * sizeof(color));
+  assert(colors);
+  bool found = diagram_sample_colors(d, colors);
+  for (uint x = 0; x < d->z.nb_vars && found; x++)
+    game_set_color(g, x / d->nb_cols, x % d->nb_cols, colors[x]);
+  free(colors);
+  return found;
+}
+
+/* ************************************************************************** */
+/*                                 FILES                                      */
+/* ************************************************************************** */
+
+bool diagram_save(diagram d, FILE* f) {
+  const zdd* z = &d->z;
+  fprintf(f, "%u %u %u %u\n", d->nb_rows, d->nb_cols, z->nb_nodes, z->root);
+  for (uint p = 0; p < z->nb_vars; p++)
+    fprintf(f, "%u%c", d->order[p], (p + 1 == z->nb_vars) ? '\n' : ' ');
+  for (uint k = ZDD_TRUE + 1; k < z->nb_nodes; k++)
+    fprintf(f, "%u %u %u\n", z->var[k], z->lo[k], z->hi[k]);
+  return fflush(f) == 0 && !ferror(f);
+}
+
+/* ************************************************************************** */
+
+/* Reads the order and the nodes of a diagram: node k of the file becomes node
+ * ids[k] of the store. */
+static bool _load(FILE* f, diagram d, uint nb_nodes, uint* ids) {
+  zdd* z = &d->z;
+  uint n = z->nb_vars;
+  bool* seen = (bool*)calloc(n + 1, sizeof(bool));
+  assert(seen);
+  bool ok = true;
+  for (uint p = 0; p < n && ok; p++) {
+    ok = fscanf(f, "%u", &d->order[p]) == 1 && d->order[p] < n &&
+         !seen[d->order[p]];
+    if (ok) seen[d->order[p]] = true;
+  }
+  free(seen);
+
+  ids[ZDD_FALSE] = ZDD_FALSE;
+  ids[ZDD_TRUE] = ZDD_TRUE;
+  for (uint k = ZDD_TRUE + 1; k < nb_nodes && ok; k++) {
+    uint var, lo, hi;
+    ok = fscanf(f, "%u %u %u", &var, &lo, &hi) == 3 && lo < k && hi < k;
+    if (!ok) break;
+    lo = ids[lo];
+    hi = ids[hi];
+    ok = var < z->var[lo] && var < z->var[hi];
+    if (ok) ids[k] = zdd_node(z, var, lo, hi);
+  }
+  return ok;
+}
+
+/* ************************************************************************** */
+
+diagram diagram_load(FILE* f) {
+  uint nb_rows, nb_cols, nb_nodes, root;
+  if (fscanf(f, "%u %u %u %u", &nb_rows, &nb_cols, &nb_nodes, &root) != 4 ||
+      nb_rows == 0 || nb_cols == 0 || nb_nodes <= ZDD_TRUE ||
+      root >= nb_nodes)
+    return NULL;
+
+  diagram d = _new(nb_rows, nb_cols);
+  uint* ids = (uint*)malloc(nb_nodes * sizeof(uint));
+  assert(ids);
+  bool ok = _load(f, d, nb_nodes, ids);
+  if (ok) d->z.root = ids[root];
+  free(ids);
+  if (!ok) {
+    diagram_delete(d);
+    return NULL;
+  }
+  return d;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,138 @@
+/**
+ * @file game_diagram.h
+ * @brief Compiled solution sets.
+ * @details The solutions of a game are compiled once into a reduced
+ * zero-suppressed decision diagram (ZDD): a graph whose paths from the root to
+ * the true terminal are the solutions, each node testing one square, and the
+ * equal subgraphs being shared. Counting, sampling or fixing squares then
+ * takes time linear in the number of nodes, instead of a new search, and
+ * drawing a uniform solution time linear in the number of squares. A
+ * diagram can be saved to a file, and loaded back without compiling it again.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ *
+ **/
+
+#ifndef __GAME_DIAGRAM_H__
+#define __GAME_DIAGRAM_H__
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "bigint.h"
+#include "game.h"
+
+/**
+ * @brief The compiled solutions of a game (opaque type).
+ */
+typedef struct diagram_s* diagram;
+
+/**
+ * @brief Compiles the solutions of a game.
+ * @details The diagram is built by the row DP engine, row by row along the
+ * narrower side of the grid. The colors of the game are ignored.
+ * @param g the game
+ * @return the diagram, to be freed with diagram_delete(), or NULL if the grid
+ * is too wide for the row DP engine (see ROWDP_MAX_WIDTH), or its sweep has
+ * too many states
+ */
+diagram diagram_compile(cgame g);
+
+/**
+ * @brief Deletes a diagram and frees its memory.
+ * @param d the diagram
+ */
+void diagram_delete(diagram d);
+
+/**
+ * @brief Returns the number of nodes of a diagram, terminals included.
+ * @param d the diagram
+ */
+uint diagram_nb_nodes(diagram d);
+
+/**
+ * @brief Counts the solutions of a diagram.
+ * @details The counts of all the nodes are computed by the first call, and
+ * kept for the next queries (see also diagram_solution()).
+ * @param d the diagram
+ * @return the number of solutions, to be freed with bigint_free()
+ */
+bigint* diagram_nb_solutions(diagram d);
+
+/**
+ * @brief Tests if a diagram has exactly one solution.
+ * @details Counts the paths up to 2 only, without big integers.
+ * @param d the diagram
+ */
+bool diagram_is_unique(diagram d);
+
+/**
+ * @brief Computes the squares with the same color in all the solutions.
+ * @details A square is black in some solution if a node tests it, and white
+ * in some solution if a white edge leaves such a node, or an edge skips it.
+ * @param d the diagram
+ * @param fixed array of nb_rows * nb_cols colors (row-major), set to the color
+ * of each backbone square, and EMPTY for the other squares (all of them if
+ * there is no solution)
+ * @return true if there is a solution, false otherwise
+ */
+bool diagram_backbone(diagram d, color* fixed);
+
+/**
+ * @brief Sets a game to the k-th solution of a diagram.
+ * @details The solutions are ordered as the paths of the diagram, white
+ * before black: the walk from the root takes the white child while k is below
+ * its count, and subtracts this count otherwise.
+ * @param d the diagram
+ * @param k the index of the solution, from 0
+ * @param g the game the diagram was compiled from, whose colors are set
+ * @return true if the solution exists (k below the number of solutions), false
+ * otherwise (the game is then unchanged)
+ */
+bool diagram_solution(diagram d, const bigint* k, game g);
+
+/**
+ * @brief Draws a solution uniformly at random.
+ * @details The walk from the root takes the black child of each node with
+ * probability count(black child) / count(node), computed once for all the
+ * nodes by the first call: a draw then takes time linear in the number of
+ * squares, whatever the number of solutions. The random numbers come from
+ * rand(), and the probabilities are doubles, so the distribution is uniform
+ * up to rounding errors.
+ * @param d the diagram
+ * @param colors array of nb_rows * nb_cols colors (row-major), set to the
+ * solution
+ * @return true if there is a solution, false otherwise (the array is then
+ * unchanged)
+ */
+bool diagram_sample_colors(diagram d, color* colors);
+
+/**
+ * @brief Sets a game to a solution drawn uniformly at random.
+ * @details Same as diagram_sample_colors(), with the colors set in a game.
+ * @param d the diagram
+ * @param g the game the diagram was compiled from, whose colors are set
+ * @return true if there is a solution, false otherwise (the game is then
+ * unchanged)
+ */
+bool diagram_sample(diagram d, game g);
+
+/**
+ * @brief Writes a diagram in text form.
+ * @details The text holds the size of the grid, the square of each variable,
+ * and a line per node with its variable and children.
+ * @param d the diagram
+ * @param f the output stream
+ * @return true if the diagram is written, false otherwise
+ */
+bool diagram_save(diagram d, FILE* f);
+
+/**
+ * @brief Reads a diagram written by diagram_save().
+ * @details The nodes are shared again while they are read, so the diagram
+ * is reduced whatever the input.
+ * @param f the input stream
+ * @return the diagram, to be freed with diagram_delete(), or NULL if the input
+ * is not a valid diagram
+ */
+diagram diagram_load(FILE* f);
+
+#endif  // __GAME_DIAGRAM_H__
@@ -0,0 +1,205 @@
+/**
+ * @file game_estimate.c
+ * @brief Approximate solution counting by random probes of the search tree.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* quantile of the normal distribution for a 95% confidence interval */
+#define Z_95 1.96
+
+/* search nodes after which a component is estimated instead of counted */
+#define EXACT_NODES 1000
+
+/* Running sums of the probe estimates 2^l of a component, scaled by 2^-max to
+ * stay finite: sum1 is the sum of 2^(l - max), and sum2 the sum of
+ * 2^(2 * (l - max)). */
+typedef struct {
+  solver* t;    // the component
+  uint64_t nb;  // number of probes
+  double max;
+  double sum1, sum2;
+  bool found;  // true if a probe reached a solution
+} probe_sums;
+
+/* ************************************************************************** */
+/*                                 PROBES                                     */
+/* ************************************************************************** */
+
+static double _now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ************************************************************************** */
+
+/* Walks down one random branch of the search tree, and returns the base-2
+ * logarithm of its estimate: each decision where both colors propagate
+ * without conflict doubles it, and so does each free cell at the end
+ * (-INFINITY if the branch ends in a conflict). The solver is restored. */
+static double _probe(solver* s) {
+  uint start = solver_mark(s), pos = s->free_pos;
+  double log2_weight = 0.0;
+  for (;;) {
+    uint x = solver_choose(s);
+    if (x == s->nb_cells || solver_is_free(s, x)) {
+      log2_weight += s->nb_free_empty;
+      break;
+    }
+    s->nb_nodes++;
+
+    // the other color is only tried to know if the choice was forced
+    color c = (rand() % 2) ? BLACK : WHITE;
+    color other = (c == BLACK) ? WHITE : BLACK;
+    uint mark = solver_mark(s);
+    bool other_ok = solver_assign(s, x, other) && solver_propagate(s);
+    solver_undo(s, mark);
+    if (solver_assign(s, x, c) && solver_propagate(s)) {
+      if (other_ok) log2_weight += 1.0;
+      continue;
+    }
+    solver_undo(s, mark);
+    if (!other_ok) {
+      log2_weight = -INFINITY;
+      break;
+    }
+    bool ok = solver_assign(s, x, other) && solver_propagate(s);
+    assert(ok);
+    (void)ok;
+  }
+  solver_undo(s, start);
+  s->free_pos = pos;
+  return log2_weight;
+}
+
+/* ************************************************************************** */
+
+static void _add(probe_sums* ps, double log2_weight) {
+  ps->nb++;
+  if (log2_weight == -INFINITY) return;
+  ps->found = true;
+  if (log2_weight > ps->max) {
+    double scale = exp2(ps->max - log2_weight);
+    ps->sum1 *= scale;
+    ps->sum2 *= scale * scale;
+    ps->max = log2_weight;
+  }
+  double w = exp2(log2_weight - ps->max);
+  ps->sum1 += w;
+  ps->sum2 += w * w;
+}
+
+/* ************************************************************************** */
+
+/* Counts a component if its search tree is small: returns false if it is
+ * not, and otherwise adds the base-2 logarithm of its count to log2_count
+ * (-INFINITY if it has no solution). */
+static bool _count_small(solver* t, double* log2_count) {
+  if (t->conflict) {
+    *log2_count = -INFINITY;
+    return true;
+  }
+  t->max_nodes = EXACT_NODES;
+  uint64_t nb = solver_count(t);
+  t->max_nodes = 0;
+  if (t->nb_nodes >= EXACT_NODES) return false;
+  *log2_count += (nb > 0) ? log2((double)nb) : -INFINITY;
+  return true;
+}
+
+/* ************************************************************************** */
+/*                            ESTIMATOR ENGINE                                */
+/* ************************************************************************** */
+
+void estimate_count(solver* s, double budget, uint64_t max_probes,
+                    solution_estimate* est) {
+  est->nb_probes = 0;
+  est->log10_estimate = est->log10_low = est->log10_high = -INFINITY;
+  if (s->conflict) return;
+  double start_time = _now();
+
+  // the small components are counted, the other ones are kept for probes
+  uint* start = (uint*)malloc((s->nb_cells + 2) * sizeof(uint));
+  uint* cells = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  probe_sums* comps = (probe_sums*)malloc((s->nb_cells + 1) * sizeof(*comps));
+  assert(start && cells && comps);
+  uint nb_comps = solver_split(s, start, cells), nb_probed = 0;
+  double log2_exact = 0.0;
+  for (uint c = 0; c < nb_comps && log2_exact > -INFINITY; c++) {
+    if (solver_is_free(s, cells[start[c]])) {
+      log2_exact += 1.0;  // a free cell is a component on its own
+      continue;
+    }
+    solver* t = solver_extract(s, cells + start[c], start[c + 1] - start[c]);
+    if (_count_small(t, &log2_exact)) {
+      s->nb_nodes += t->nb_nodes;
+      solver_delete(t);
+    } else {
+      comps[nb_probed++] = (probe_sums){t, 0, -INFINITY, 0.0, 0.0, false};
+    }
+  }
+
+  // one probe per component and per round, until the budget is spent
+  while (nb_probed > 0 && log2_exact > -INFINITY) {
+    for (uint c = 0; c < nb_probed; c++) _add(&comps[c], _probe(comps[c].t));
+    est->nb_probes += nb_probed;
+    // without a number of probes, a time budget of 0 is a single round
+    bool timed = budget > 0.0 || max_probes == 0;
+    if (timed && _now() - start_time >= budget) break;
+    if (max_probes > 0 && est->nb_probes >= max_probes) break;
+  }
+
+  // the relative variances of the independent means add up (to first order)
+  double log10_2 = log10(2.0), rel_var = 0.0;
+  bool found = log2_exact > -INFINITY;
+  est->log10_estimate = log2_exact * log10_2;
+  for (uint c = 0; c < nb_probed; c++) {
+    probe_sums* ps = &comps[c];
+    s->nb_nodes += ps->t->nb_nodes;
+    solver_delete(ps->t);
+    if (!found || !ps->found) {
+      found = false;
+      continue;
+    }
+    // a single probe says nothing about the variance
+    double mean = ps->sum1 / ps->nb;
+    double var = (ps->nb > 1)
+                     ? (ps->sum2 - ps->nb * mean * mean) / (ps->nb - 1)
+                     : INFINITY;
+    if (var > 0.0) rel_var += var / (ps->nb * mean * mean);
+    est->log10_estimate += log10(mean) + ps->max * log10_2;
+  }
+  free(start);
+  free(cells);
+  free(comps);
+
+  if (!found) {
+    // no probe of a component met a solution: there may be none
+    est->log10_estimate = -INFINITY;
+    est->log10_high = (log2_exact > -INFINITY) ? INFINITY : -INFINITY;
+    return;
+  }
+  double err = Z_95 * sqrt(rel_var);
+  est->log10_high = est->log10_estimate + log10(1.0 + err);
+  // each component has a solution, so there is at least one
+  est->log10_low = (err < 1.0) ? est->log10_estimate + log10(1.0 - err) : 0.0;
+  if (est->log10_low < 0.0) est->log10_low = 0.0;
+}
+
+/* ************************************************************************** */
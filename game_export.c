@@ -0,0 +1,389 @@
+/**
+ * @file game_export.c
+ * @brief Export to SAT and pseudo-boolean solvers, and import of their models.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include <assert.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_ext.h"
+#include "game_private.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* size of the output buffer */
+#define BUFFER_SIZE (1 << 16)
+
+/* maximal number of cells in a neighbourhood */
+#define MAX_CELLS 9
+
+/* maximal number of literals of a pattern, with the clause terminators */
+#define MAX_LITS (4 * 4 * MAX_CELLS * (MAX_CELLS + 1))
+
+/* number of local variables of a pattern (cells and auxiliary variables) */
+#define MAX_VARS INT8_MAX
+
+/* maximal length of a clause in text: at most 3 literals of at most 20
+ * digits, a sign and a separator each, then "0\n", and the slack of the
+ * fixed-size copies of the literals */
+#define CLAUSE_CHARS (3 * 22 + 2 + 24)
+
+/* Literal constants of the counter encoding (variables are positive). */
+#define LIT_TRUE INT8_MAX
+#define LIT_FALSE (-INT8_MAX)
+
+/* A constrained square: its cells (variables 1..nb_cells, row-major) with
+ * their multiplicity, and its number of black cells. */
+typedef struct {
+  uint n;
+  int64_t vars[MAX_CELLS];
+  uint weights[MAX_CELLS];
+  int need;
+} square;
+
+/* The clauses of a square, with local literals: +-t for its cell t (1-based)
+ * and +-(MAX_CELLS + a) for its auxiliary variable a (1-based). The clauses
+ * are terminated by 0. The pattern only depends on the weights and on the
+ * constraint, so that it is shared by most squares of the grid. */
+typedef struct {
+  bool done;
+  uint nb_aux;
+  uint nb_clauses;
+  uint len;
+  int8_t lits[MAX_LITS];
+} pattern;
+
+/* Buffered output. With no file, the variables and clauses are only counted.
+ * The patterns of the squares with simple weights are indexed by their number
+ * of cells and their constraint. */
+typedef struct {
+  FILE* f;
+  uint len;
+  uint64_t nb_vars;
+  uint64_t nb_clauses;
+  pattern simple[MAX_CELLS + 1][MAX_CONSTRAINT + 1];
+  pattern weighted;
+  char buf[BUFFER_SIZE];
+} writer;
+
+/* ************************************************************************** */
+/*                                  OUTPUT                                    */
+/* ************************************************************************** */
+
+static void _flush(writer* w) {
+  if (w->f && w->len > 0) fwrite(w->buf, 1, w->len, w->f);
+  w->len = 0;
+}
+
+/* ************************************************************************** */
+
+static void _put_str(writer* w, const char* str) {
+  if (!w->f) return;
+  uint n = strlen(str);
+  if (w->len + n > BUFFER_SIZE) _flush(w);
+  memcpy(w->buf + w->len, str, n);
+  w->len += n;
+}
+
+/* ************************************************************************** */
+
+/* Writes the decimal digits of an integer, and returns their number. */
+static inline uint _digits(char* str, uint64_t u) {
+  uint n = 1;
+  for (uint64_t t = u; t >= 10; t /= 10) n++;
+  char* p = str + n;
+  do {
+    *--p = '0' + u % 10;
+    u /= 10;
+  } while (u > 0);
+  return n;
+}
+
+/* ************************************************************************** */
+
+/* Writes an integer followed by a separator, without printf. */
+static inline void _put_int(writer* w, int64_t v, char sep) {
+  if (w->len + 24 > BUFFER_SIZE) _flush(w);
+  uint64_t u = (v < 0) ? -(uint64_t)v : (uint64_t)v;
+  if (v < 0) w->buf[w->len++] = '-';
+  w->len += _digits(w->buf + w->len, u);
+  w->buf[w->len++] = sep;
+}
+
+/* ************************************************************************** */
+/*                                 SQUARES                                    */
+/* ************************************************************************** */
+
+/* Gets the constrained square (i, j), merging the cells counted several times
+ * on small wrapping grids. Returns false if the square is unconstrained. */
+static bool _square(cgame g, uint i, uint j, square* sq) {
+  constraint c = game_get_constraint(g, i, j);
+  if (c == UNCONSTRAINED) return false;
+  neighbourhood neigh = game_get_neighbourhood(g);
+  sq->n = 0;
+  sq->need = c;
+  for (uint d = 0; d < DIR_SIZES[neigh]; d++) {
+    uint ii, jj;
+    if (!game_get_next_square(g, i, j, DIR_ARRAYS[neigh][d], &ii, &jj))
+      continue;
+    int64_t x = ii * game_nb_cols(g) + jj + 1;
+    uint t = 0;
+    while (t < sq->n && sq->vars[t] != x) t++;
+    if (t == sq->n) {
+      sq->vars[sq->n] = x;
+      sq->weights[sq->n++] = 0;
+    }
+    sq->weights[t]++;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Adds a clause over local literals and constants to a pattern: a clause with
+ * a true literal is dropped, and so are the false literals. */
+static void _add_clause(pattern* p, const int* lits, uint n) {
+  for (uint t = 0; t < n; t++)
+    if (lits[t] == LIT_TRUE) return;
+  for (uint t = 0; t < n; t++)
+    if (lits[t] != LIT_FALSE) p->lits[p->len++] = lits[t];
+  p->lits[p->len++] = 0;
+  p->nb_clauses++;
+}
+
+/* ************************************************************************** */
+
+/* Encodes "the weighted sum of the cells is need" with a sequential counter:
+ * s(i, j) holds if the first i cells count at least j black cells, defined by
+ * s(i, j) <-> s(i-1, j) or (x_i and s(i-1, j-w_i)). The counters whose value
+ * is known are replaced by constants: s(i, j) is true if j <= 0 or if the
+ * cells after i are not enough to reach need from below j, and false if j is
+ * beyond need or beyond the weight of the first i cells. The counter grows
+ * with need, so when more than half of the weight is black, the white cells
+ * are counted instead: their sum is total - need, on the negated cells. */
+static void _make_pattern(pattern* p, const square* sq) {
+  int k = sq->need, total = 0;
+  for (uint i = 0; i < sq->n; i++) total += sq->weights[i];
+  p->nb_aux = 0;
+  p->nb_clauses = 0;
+  p->len = 0;
+  if (k > total) {
+    _add_clause(p, NULL, 0);  // no solution
+    return;
+  }
+  int sign = 1;
+  if (k > total - k) {
+    k = total - k;
+    sign = -1;
+  }
+
+  // counter variables, for i = 0..n and j = 0..k+1
+  int s[MAX_CELLS + 1][MAX_CONSTRAINT + 2];
+  int prefix = 0;
+  for (uint i = 0; i <= sq->n; i++) {
+    if (i > 0) prefix += sq->weights[i - 1];
+    int low = k - (total - prefix);  // s(i, j) holds for j <= low
+    for (int j = 0; j <= k + 1; j++) {
+      if (j <= 0 || j <= low)
+        s[i][j] = LIT_TRUE;
+      else if (j > k || j > prefix)
+        s[i][j] = LIT_FALSE;
+      else
+        s[i][j] = MAX_CELLS + ++p->nb_aux;
+    }
+  }
+
+  for (uint i = 1; i <= sq->n; i++) {
+    int x = sign * (int)i, wi = sq->weights[i - 1];
+    for (int j = 1; j <= k + 1; j++) {
+      int sij = s[i][j], a = s[i - 1][j];
+      int b = (j - wi <= 0) ? LIT_TRUE : s[i - 1][j - wi];
+      int c1[2] = {-a, sij};      // s(i-1, j) -> s(i, j)
+      int c2[3] = {-x, -b, sij};  // x_i and s(i-1, j-w) -> s(i, j)
+      int c3[3] = {-sij, a, x};   // s(i, j) -> s(i-1, j) or x_i
+      int c4[3] = {-sij, a, b};   // s(i, j) -> s(i-1, j) or s(..)
+      _add_clause(p, c1, 2);
+      _add_clause(p, c2, 3);
+      _add_clause(p, c3, 3);
+      _add_clause(p, c4, 3);
+    }
+  }
+}
+
+/* ************************************************************************** */
+
+/* Encodes a square with its pattern (counting only if w->f is NULL). */
+static void _encode_square(writer* w, const square* sq) {
+  bool simple = true;
+  for (uint t = 0; t < sq->n; t++)
+    if (sq->weights[t] != 1) simple = false;
+  pattern* p = simple ? &w->simple[sq->n][sq->need] : &w->weighted;
+  if (!simple || !p->done) _make_pattern(p, sq);
+  p->done = true;
+
+  uint64_t base = w->nb_vars - MAX_CELLS;
+  w->nb_vars += p->nb_aux;
+  w->nb_clauses += p->nb_clauses;
+  if (!w->f) return;
+
+  // the digits of each variable are written once for all the clauses of the
+  // square, which are then copied one at a time into the buffer
+  char text[MAX_VARS][24];
+  uint8_t text_len[MAX_VARS];
+  for (uint t = 1; t <= sq->n; t++)
+    text_len[t] = _digits(text[t], sq->vars[t - 1]);
+  for (uint t = MAX_CELLS + 1; t <= MAX_CELLS + p->nb_aux; t++)
+    text_len[t] = _digits(text[t], base + t);
+  for (uint r = 0; r < p->len; r++) {
+    if (w->len + CLAUSE_CHARS > BUFFER_SIZE) _flush(w);
+    char* out = w->buf + w->len;
+    for (; p->lits[r] != 0; r++) {
+      int lit = p->lits[r];
+      uint t = abs(lit);
+      if (lit < 0) *out++ = '-';
+      memcpy(out, text[t], 24);  // a fixed size is a few moves, not a call
+      out += text_len[t];
+      *out++ = ' ';
+    }
+    *out++ = '0';
+    *out++ = '\n';
+    w->len = out - w->buf;
+  }
+}
+
+/* ************************************************************************** */
+
+/* Encodes all the squares (counting only if w->f is NULL). */
+static void _encode(writer* w, cgame g) {
+  square sq;
+  for (uint i = 0; i < game_nb_rows(g); i++)
+    for (uint j = 0; j < game_nb_cols(g); j++)
+      if (_square(g, i, j, &sq)) _encode_square(w, &sq);
+}
+
+/* ************************************************************************** */
+/*                                  EXPORT                                    */
+/* ************************************************************************** */
+
+void game_export_cnf(cgame g, FILE* f) {
+  assert(g && f);
+  uint nb_cells = game_nb_rows(g) * game_nb_cols(g);
+  writer* w = (writer*)malloc(sizeof(writer));
+  assert(w);
+
+  // first pass to count the variables and clauses of the header
+  w->f = NULL;
+  w->len = 0;
+  for (uint n = 0; n <= MAX_CELLS; n++)
+    for (uint k = 0; k <= MAX_CONSTRAINT; k++) w->simple[n][k].done = false;
+  w->nb_vars = nb_cells;
+  w->nb_clauses = 0;
+  _encode(w, g);
+  fprintf(f, "c mosaic %u x %u, cell (i, j) is variable i * %u + j + 1\n",
+          game_nb_rows(g), game_nb_cols(g), game_nb_cols(g));
+  fprintf(f, "p cnf %" PRIu64 " %" PRIu64 "\n", w->nb_vars, w->nb_clauses);
+
+  w->f = f;
+  w->nb_vars = nb_cells;
+  w->nb_clauses = 0;
+  _encode(w, g);
+  _flush(w);
+  free(w);
+}
+
+/* ************************************************************************** */
+
+void game_export_opb(cgame g, FILE* f) {
+  assert(g && f);
+  uint nb_cons = 0;
+  for (uint i = 0; i < game_nb_rows(g); i++)
+    for (uint j = 0; j < game_nb_cols(g); j++)
+      if (game_get_constraint(g, i, j) != UNCONSTRAINED) nb_cons++;
+  fprintf(f, "* #variable= %u #constraint= %u\n",
+          game_nb_rows(g) * game_nb_cols(g), nb_cons);
+
+  writer* w = (writer*)malloc(sizeof(writer));
+  assert(w);
+  w->f = f;
+  w->len = 0;
+  square sq;
+  for (uint i = 0; i < game_nb_rows(g); i++)
+    for (uint j = 0; j < game_nb_cols(g); j++) {
+      if (!_square(g, i, j, &sq)) continue;
+      for (uint t = 0; t < sq.n; t++) {
+        _put_str(w, "+");
+        _put_int(w, sq.weights[t], ' ');
+        _put_str(w, "x");
+        _put_int(w, sq.vars[t], ' ');
+      }
+      _put_str(w, "= ");
+      _put_int(w, sq.need, ' ');
+      _put_str(w, ";\n");
+    }
+  _flush(w);
+  free(w);
+}
+
+/* ************************************************************************** */
+/*                                  IMPORT                                    */
+/* ************************************************************************** */
+
+bool game_import_model(game g, FILE* f) {
+  assert(g && f);
+  uint nb_cells = game_nb_rows(g) * game_nb_cols(g);
+  color* colors = (color*)malloc((nb_cells + 1) * sizeof(color));
+  assert(colors);
+  for (uint x = 0; x < nb_cells; x++) colors[x] = EMPTY;
+
+  // literals are read from the value lines ("v ...") or from bare lines of
+  // numbers; comments, status and objective lines are skipped
+  bool ok = true;
+  int ch;
+  while (ok && (ch = getc(f)) != EOF) {
+    if (ch == 'v') {
+      ch = getc(f);
+    } else if (!isdigit(ch) && ch != '-' && ch != 'x' && !isspace(ch)) {
+      char line[256];
+      ungetc(ch, f);
+      if (fgets(line, sizeof(line), f) && strstr(line, "UNSAT")) ok = false;
+      while (!strchr(line, '\n') && fgets(line, sizeof(line), f)) continue;
+      continue;
+    }
+    while (ch != '\n' && ch != EOF) {
+      if (ch != '-' && ch != 'x' && !isdigit(ch)) {
+        ch = getc(f);
+        continue;
+      }
+      bool neg = (ch == '-');
+      if (neg) ch = getc(f);
+      if (ch == 'x') ch = getc(f);
+      uint64_t v = 0;
+      while (isdigit(ch)) {
+        if (v <= nb_cells) v = 10 * v + (ch - '0');
+        ch = getc(f);
+      }
+      if (v >= 1 && v <= nb_cells) colors[v - 1] = neg ? WHITE : BLACK;
+    }
+  }
+
+  for (uint x = 0; x < nb_cells && ok; x++)
+    if (colors[x] == EMPTY) ok = false;
+  if (ok)
+    for (uint x = 0; x < nb_cells; x++)
+      game_set_color(g, x / game_nb_cols(g), x % game_nb_cols(g), colors[x]);
+  free(colors);
+  return ok;
+}
+
+/* ************************************************************************** */
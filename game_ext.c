@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "game.h"
 #include "game_private.h"
@@ -31,7 +32,7 @@ game game_new_ext(uint nb_rows, uint nb_cols, constraint* constraints,
       int n = constraints[i * nb_cols + j];
       if (colors != NULL) c = colors[i * nb_cols + j];
       CONSTRAINT(g, i, j) = n;
-      COLOR(g, i, j) = c;
+      SET_COLOR(g, i, j, c);
     }
 
   return g;
@@ -47,13 +48,16 @@ game game_new_empty_ext(uint nb_rows, uint nb_cols, bool wrapping,
   g->nb_cols = nb_cols;
   g->wrapping = wrapping;
   g->neigh = neigh;
-  g->squares = (square*)calloc(g->nb_rows * g->nb_cols, sizeof(square));
-  assert(g->squares);
-  for (uint i = 0; i < g->nb_rows; i++)
-    for (uint j = 0; j < g->nb_cols; j++) {
-      CONSTRAINT(g, i, j) = UNCONSTRAINED;
-      COLOR(g, i, j) = EMPTY;
-    }
+  g->constraints = (signed char*)malloc(nb_rows * nb_cols + 1);
+  assert(g->constraints);
+  memset(g->constraints, UNCONSTRAINED, nb_rows * nb_cols);
+
+  // all squares are empty: no bit set in both bitboards
+  g->row_words = (nb_cols + 63) / 64;
+  g->black = (uint64_t*)calloc(nb_rows * g->row_words + 1, sizeof(uint64_t));
+  assert(g->black);
+  g->white = (uint64_t*)calloc(nb_rows * g->row_words + 1, sizeof(uint64_t));
+  assert(g->white);
 
   // initialize history
   g->undo_stack = queue_new();
@@ -0,0 +1,208 @@
+/**
+ * @file game_linear.c
+ * @brief Propagation with linear equations over the constraints.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* A block is the system of a constraint and of its overlapping constraints,
+ * restricted to their empty cells: at most 25 equations (FULL neighbourhood)
+ * over at most 49 cells. */
+#define MAX_ROWS 25
+#define MAX_COLS 49
+
+/* rows with larger coefficients are dropped, so that products never overflow
+ */
+#define MAX_COEF (1 << 24)
+
+/* Row i is the equation sum_j a[i][j] * x_j = a[i][MAX_COLS], where x_j is 1
+ * if cell cols[j] is black. */
+typedef struct {
+  uint nb_rows;
+  uint nb_cols;
+  uint cols[MAX_COLS];
+  int64_t a[MAX_ROWS][MAX_COLS + 1];
+} block;
+
+/* ************************************************************************** */
+/*                                  BLOCKS                                    */
+/* ************************************************************************** */
+
+/* Adds the residual equation of constraint k to the block. */
+static void _add_row(block* b, const solver* s, uint k) {
+  if (b->nb_rows == MAX_ROWS) return;
+  int64_t* row = b->a[b->nb_rows];
+  memset(row, 0, sizeof(b->a[0]));
+  for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+    uint x = s->cons_cells[p];
+    if (s->colors[x] != EMPTY) continue;
+    uint j = 0;
+    while (j < b->nb_cols && b->cols[j] != x) j++;
+    if (j == b->nb_cols) {
+      if (j == MAX_COLS) return;  // never happens with the 4 neighbourhoods
+      b->cols[b->nb_cols++] = x;
+    }
+    row[j] += s->cons_weights[p];
+  }
+  row[MAX_COLS] = s->cons_need[k] - s->cons_black[k];
+  b->nb_rows++;
+}
+
+/* ************************************************************************** */
+
+static int64_t _gcd(int64_t a, int64_t b) {
+  if (a < 0) a = -a;
+  if (b < 0) b = -b;
+  while (b) {
+    int64_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/* ************************************************************************** */
+
+/* Divides a row by the gcd of its coefficients. Returns false if the equation
+ * has no integer solution. Rows with too large coefficients are cleared. */
+static bool _normalize(block* b, int64_t* row) {
+  int64_t g = 0;
+  for (uint j = 0; j < b->nb_cols; j++) g = _gcd(g, row[j]);
+  if (g == 0) return row[MAX_COLS] == 0;
+  if (row[MAX_COLS] % g != 0) return false;
+  bool large = false;
+  for (uint j = 0; j < b->nb_cols; j++) row[j] /= g;
+  row[MAX_COLS] /= g;
+  for (uint j = 0; j <= MAX_COLS; j++)
+    if (row[j] >= MAX_COEF || row[j] <= -MAX_COEF) large = true;
+  if (large) memset(row, 0, sizeof(b->a[0]));
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Gauss-Jordan elimination with integer rows. The cells shared by the most
+ * equations are eliminated first, so that the reduced rows relate the cells
+ * private to each constraint. Returns false if the system is inconsistent. */
+static bool _reduce(block* b) {
+  uint order[MAX_COLS], degree[MAX_COLS];
+  for (uint j = 0; j < b->nb_cols; j++) {
+    degree[j] = 0;
+    for (uint i = 0; i < b->nb_rows; i++)
+      if (b->a[i][j] != 0) degree[j]++;
+    uint t = j;
+    while (t > 0 && degree[order[t - 1]] < degree[j]) {
+      order[t] = order[t - 1];
+      t--;
+    }
+    order[t] = j;
+  }
+
+  uint r = 0;
+  for (uint t = 0; t < b->nb_cols && r < b->nb_rows; t++) {
+    uint j = order[t];
+    // pivot with the smallest coefficient
+    uint p = b->nb_rows;
+    for (uint i = r; i < b->nb_rows; i++)
+      if (b->a[i][j] != 0 &&
+          (p == b->nb_rows || llabs(b->a[i][j]) < llabs(b->a[p][j])))
+        p = i;
+    if (p == b->nb_rows) continue;
+    if (p != r) {
+      int64_t tmp[MAX_COLS + 1];
+      memcpy(tmp, b->a[p], sizeof(tmp));
+      memcpy(b->a[p], b->a[r], sizeof(tmp));
+      memcpy(b->a[r], tmp, sizeof(tmp));
+    }
+    int64_t f = b->a[r][j];
+    for (uint i = 0; i < b->nb_rows; i++) {
+      if (i == r || b->a[i][j] == 0) continue;
+      int64_t g = b->a[i][j];
+      for (uint c = 0; c < b->nb_cols; c++)
+        b->a[i][c] = b->a[i][c] * f - b->a[r][c] * g;
+      b->a[i][MAX_COLS] = b->a[i][MAX_COLS] * f - b->a[r][MAX_COLS] * g;
+      if (!_normalize(b, b->a[i])) return false;
+    }
+    r++;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Bound reasoning on a row: x_j can take value v only if the rest of the row
+ * can still reach rhs - a_j * v. Forced cells are stored in force[] (0 for
+ * white, 1 for black, -1 if undecided). Returns false on a conflict. */
+static bool _bounds(const block* b, const int64_t* row, int* force) {
+  int64_t lo = 0, hi = 0;
+  for (uint j = 0; j < b->nb_cols; j++) {
+    if (row[j] < 0) lo += row[j];
+    if (row[j] > 0) hi += row[j];
+  }
+  int64_t rhs = row[MAX_COLS];
+  if (rhs < lo || rhs > hi) return false;
+  for (uint j = 0; j < b->nb_cols; j++) {
+    int64_t a = row[j];
+    if (a == 0) continue;
+    int64_t rest_lo = lo - (a < 0 ? a : 0), rest_hi = hi - (a > 0 ? a : 0);
+    bool white = rest_lo <= rhs && rhs <= rest_hi;
+    bool black = rest_lo <= rhs - a && rhs - a <= rest_hi;
+    if (!white && !black) return false;
+    int v = white ? (black ? -1 : 0) : 1;
+    if (v < 0) continue;
+    if (force[j] >= 0 && force[j] != v) return false;
+    force[j] = v;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+/*                              LINEAR ENGINE                                 */
+/* ************************************************************************** */
+
+bool linear_propagate(solver* s) {
+  block b;
+  int force[MAX_COLS];
+  while (s->lqueue_size > 0) {
+    uint k = s->lqueue[--s->lqueue_size];
+    s->lqueued[k] = false;
+    if (s->cons_empty[k] == 0) continue;
+
+    // the constraint and its overlapping constraints
+    b.nb_rows = 0;
+    b.nb_cols = 0;
+    _add_row(&b, s, k);
+    for (uint r = s->pair_start[k]; r < s->pair_start[k + 1]; r++)
+      if (s->cons_empty[s->pair_cons[r]] > 0)
+        _add_row(&b, s, s->pair_cons[r]);
+    if (b.nb_rows < 2) continue;
+
+    if (!_reduce(&b)) return false;
+    for (uint j = 0; j < b.nb_cols; j++) force[j] = -1;
+    for (uint i = 0; i < b.nb_rows; i++)
+      if (!_bounds(&b, b.a[i], force)) return false;
+
+    bool forced = false;
+    for (uint j = 0; j < b.nb_cols; j++) {
+      if (force[j] < 0) continue;
+      if (!solver_assign(s, b.cols[j], force[j] ? BLACK : WHITE)) return false;
+      forced = true;
+    }
+    if (forced) return true;  // back to the counters
+  }
+  return true;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,821 @@
+/**
+ * @file game_logic.c
+ * @brief Rule-based logical solver, without any guess, and difficulty grading.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_ext.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* Cells to try again with the chain rule when a constraint changes. */
+typedef struct {
+  uint* cells;
+  uint size;
+  uint capacity;
+} watch_list;
+
+/* State of the logical solver. The solver holds the colors and the counters of
+ * the constraints: its queue lists the constraints to check with the
+ * saturation rule, and the dirty list the constraints to check with the pair
+ * rule. The deductions are recorded, except while a chain is explored, and
+ * their clues are kept for the dead-end detection (which uses no chain). A
+ * color that a chain try assigns without contradiction is safe: trying it
+ * would deduce a part of the same cells. It stays safe until a recorded
+ * deduction changes a constraint, or an overlapping one, of that try, since
+ * the same try would replay the same deductions otherwise. */
+typedef struct {
+  solver* s;
+  uint* dirty;       /* constraints touched since the last pair pass */
+  uint nb_dirty;     /* number of dirty constraints */
+  bool* is_dirty;    /* true if the constraint is in the dirty list */
+  uint* stamp;       /* marks of the cells of a pair */
+  uint epoch;        /* current mark */
+  uint chain_pos;    /* next cell to try with the chain rule */
+  uint8_t* safe;     /* colors (bit c) of the cell known to lead to no
+                        contradiction with the chain rule */
+  watch_list* watch; /* cells with safe colors found by a chain try that
+                        assigned cells of each constraint */
+  uint* touched;     /* constraints of the cells assigned by a chain try */
+  uint* seen;        /* marks of the touched constraints */
+  int conflict;      /* violated constraint, after a contradiction */
+  int conflict2;     /* other constraint of a contradiction (or the same) */
+  int* reason;       /* if not NULL, the constraint deducing each cell (-1 for
+                        the cells colored by the player) */
+  int* reason2;      /* the other constraint of a pair (or the same) */
+  bool recording;    /* true to record the deductions */
+  deduction* steps;  /* recorded deductions */
+  uint nb_steps;     /* number of recorded deductions */
+  uint capacity;     /* allocated size of steps */
+} logic;
+
+/* Colors forced by the pair rule on two constraints k and k2. */
+typedef struct {
+  color c1;    /* color of the cells of k only (or EMPTY) */
+  color c12;   /* color of the shared cells (or EMPTY) */
+  color c2;    /* color of the cells of k2 only (or EMPTY) */
+  uint shared; /* stamp of the shared cells */
+  uint only2;  /* stamp of the cells of k2 only */
+} pair_colors;
+
+/* Incremental state of the hints: the solver follows the colors of the game.
+ */
+struct hint_s {
+  logic l;
+};
+
+/* ************************************************************************** */
+/*                                  AUXILIARY                                 */
+/* ************************************************************************** */
+
+static bool _violated(const solver* s, uint k) {
+  return s->cons_black[k] > s->cons_need[k] ||
+         s->cons_black[k] + s->cons_empty[k] < s->cons_need[k];
+}
+
+/* ************************************************************************** */
+
+static void _set_dirty(logic* l, uint k) {
+  if (l->is_dirty[k]) return;
+  l->is_dirty[k] = true;
+  l->dirty[l->nb_dirty++] = k;
+}
+
+/* ************************************************************************** */
+
+static void _clear_dirty(logic* l) {
+  while (l->nb_dirty > 0) l->is_dirty[l->dirty[--l->nb_dirty]] = false;
+}
+
+/* ************************************************************************** */
+
+/* Describes the deduction of cell x from constraints k and k2. */
+static void _describe(const solver* s, deduction* d, uint x, color c,
+                      logic_rule rule, uint k, uint k2) {
+  d->i = x / s->nb_cols;
+  d->j = x % s->nb_cols;
+  d->c = c;
+  d->rule = rule;
+  d->clue_i = s->cons_square[k] / s->nb_cols;
+  d->clue_j = s->cons_square[k] % s->nb_cols;
+  d->other_i = s->cons_square[k2] / s->nb_cols;
+  d->other_j = s->cons_square[k2] % s->nb_cols;
+}
+
+/* ************************************************************************** */
+
+/* Records the deduction of cell x from constraints k and k2. */
+static void _record(logic* l, uint x, color c, logic_rule rule, uint k,
+                    uint k2) {
+  if (l->nb_steps == l->capacity) {
+    l->capacity = 2 * l->capacity + 16;
+    l->steps = (deduction*)realloc(l->steps, l->capacity * sizeof(deduction));
+    assert(l->steps);
+  }
+  _describe(l->s, &l->steps[l->nb_steps++], x, c, rule, k, k2);
+}
+
+/* ************************************************************************** */
+
+/* Adds cell x to the cells to try again when constraint k changes. */
+static void _watch(logic* l, uint k, uint x) {
+  watch_list* w = &l->watch[k];
+  if (w->size == w->capacity) {
+    w->capacity = 2 * w->capacity + 4;
+    w->cells = (uint*)realloc(w->cells, w->capacity * sizeof(uint));
+    assert(w->cells);
+  }
+  w->cells[w->size++] = x;
+}
+
+/* ************************************************************************** */
+
+/* Constraint k changes: its watching cells are to be tried again. */
+static void _wake(logic* l, uint k) {
+  watch_list* w = &l->watch[k];
+  while (w->size > 0) l->safe[w->cells[--w->size]] = 0;
+}
+
+/* ************************************************************************** */
+
+/* Assigns an empty cell deduced by a rule. Returns false on a contradiction,
+ * with the violated constraint in l->conflict. */
+static bool _deduce(logic* l, uint x, color c, logic_rule rule, uint k,
+                    uint k2) {
+  solver* s = l->s;
+  if (l->recording) _record(l, x, c, rule, k, k2);
+  if (l->reason) {
+    l->reason[x] = k;
+    l->reason2[x] = k2;
+  }
+  bool ok = solver_assign(s, x, c);
+  for (uint p = s->cell_start[x]; p < s->cell_start[x + 1]; p++) {
+    uint k3 = s->cell_cons[p];
+    _set_dirty(l, k3);
+    if (!ok && _violated(s, k3)) l->conflict = l->conflict2 = k3;
+    if (!l->safe || !l->recording) continue;
+    _wake(l, k3);
+    for (uint r = s->pair_start[k3]; r < s->pair_start[k3 + 1]; r++)
+      _wake(l, s->pair_cons[r]);
+  }
+  return ok;
+}
+
+/* Sets up the logical solver on solver s. */
+static void _init(logic* l, solver* s) {
+  *l = (logic){.s = s, .conflict = -1, .conflict2 = -1, .recording = true};
+  l->dirty = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  l->is_dirty = (bool*)calloc(s->nb_cons + 1, sizeof(bool));
+  l->stamp = (uint*)calloc(s->nb_cells + 1, sizeof(uint));
+  assert(l->dirty && l->is_dirty && l->stamp);
+}
+
+/* ************************************************************************** */
+
+/* Frees the logical solver, but not its solver nor its deductions. */
+static void _free(logic* l) {
+  free(l->dirty);
+  free(l->is_dirty);
+  free(l->stamp);
+  free(l->reason);
+  free(l->reason2);
+  if (l->watch)
+    for (uint k = 0; k < l->s->nb_cons; k++) free(l->watch[k].cells);
+  free(l->watch);
+  free(l->safe);
+  free(l->touched);
+  free(l->seen);
+}
+
+/* ************************************************************************** */
+/*                                   RULES                                    */
+/* ************************************************************************** */
+
+/* A 0 clue makes all its cells white, and a clue equal to the size of its
+ * neighbourhood makes them all black. */
+static bool _trivial(logic* l) {
+  solver* s = l->s;
+  for (uint k = 0; k < s->nb_cons; k++) {
+    int total = 0;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++)
+      total += s->cons_weights[p];
+    if (s->cons_need[k] != 0 && s->cons_need[k] != total) continue;
+    color c = (s->cons_need[k] == 0) ? WHITE : BLACK;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] != EMPTY) continue;
+      if (!_deduce(l, x, c, RULE_TRIVIAL, k, k)) return false;
+    }
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* A clue with enough black cells makes its other cells white, and a clue with
+ * just enough empty cells left makes them black (the counter rule of the
+ * solver), for the constraints of the solver queue. */
+static bool _saturated(logic* l) {
+  solver* s = l->s;
+  while (s->queue_size > 0) {
+    uint k = s->queue[--s->queue_size];
+    s->queued[k] = false;
+    if (_violated(s, k)) {
+      l->conflict = l->conflict2 = k;
+      return false;
+    }
+    if (s->cons_empty[k] == 0) continue;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] != EMPTY) continue;
+      int w = s->cons_weights[p];
+      int need = s->cons_need[k];
+      if (s->cons_black[k] + w > need) {
+        if (!_deduce(l, x, WHITE, RULE_SATURATED, k, k)) return false;
+      } else if (s->cons_black[k] + s->cons_empty[k] - w < need) {
+        if (!_deduce(l, x, BLACK, RULE_SATURATED, k, k)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Overlap and subset reasoning on constraints k and k2. Their empty cells are
+ * split into the cells of k only, the shared cells and the cells of k2 only:
+ * the residual needs of both constraints bound the number of black shared
+ * cells, which in turn bounds the black cells of each side. A part is forced
+ * when its bound is tight. Only applies to cells of weight 1. Returns false on
+ * a contradiction. */
+static bool _pair_colors(logic* l, uint k, uint k2, pair_colors* pc) {
+  solver* s = l->s;
+  pc->c1 = pc->c12 = pc->c2 = EMPTY;
+  pc->shared = ++l->epoch;
+  pc->only2 = ++l->epoch;
+  int n1 = 0, n12 = 0, n2 = 0;
+  for (uint p = s->cons_start[k2]; p < s->cons_start[k2 + 1]; p++) {
+    if (s->colors[s->cons_cells[p]] != EMPTY) continue;
+    if (s->cons_weights[p] != 1) return true;
+    l->stamp[s->cons_cells[p]] = pc->only2;
+    n2++;
+  }
+  for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+    uint x = s->cons_cells[p];
+    if (s->colors[x] != EMPTY) continue;
+    if (s->cons_weights[p] != 1) return true;
+    if (l->stamp[x] == pc->only2) {
+      l->stamp[x] = pc->shared;
+      n12++;
+      n2--;
+    } else {
+      n1++;
+    }
+  }
+  if (n12 == 0) return true;
+
+  // bounds on the black shared cells
+  int r1 = s->cons_need[k] - s->cons_black[k];
+  int r2 = s->cons_need[k2] - s->cons_black[k2];
+  int lo = 0, hi = n12;
+  if (r1 - n1 > lo) lo = r1 - n1;
+  if (r2 - n2 > lo) lo = r2 - n2;
+  if (r1 < hi) hi = r1;
+  if (r2 < hi) hi = r2;
+  if (lo > hi) {
+    l->conflict = k;
+    l->conflict2 = k2;
+    return false;
+  }
+  pc->c12 = (hi == 0) ? WHITE : (lo == n12) ? BLACK : EMPTY;
+  pc->c1 = (r1 - lo == 0) ? WHITE : (r1 - hi == n1) ? BLACK : EMPTY;
+  pc->c2 = (r2 - lo == 0) ? WHITE : (r2 - hi == n2) ? BLACK : EMPTY;
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Tells from the counters whether the pair rule may force cells or find a
+ * contradiction on constraint k and its r-th overlapping one, as if all the
+ * weights were 1: a cheap filter, _pair_colors decides. When both
+ * constraints need some more black cells and some more white cells (r and s),
+ * the rule needs at least min(r1 + s2, r2 + s1) empty shared cells, so most
+ * pairs are ruled out before counting them. */
+static bool _pair_may_force(const solver* s, uint k, uint r) {
+  uint k2 = s->pair_cons[r];
+  const uint8_t* pos = s->pair_pos + r * PAIR_BYTES;
+  int r1 = s->cons_need[k] - s->cons_black[k];
+  int r2 = s->cons_need[k2] - s->cons_black[k2];
+  int s1 = s->cons_empty[k] - r1, s2 = s->cons_empty[k2] - r2;
+  if (r1 > 0 && r2 > 0 && s1 > 0 && s2 > 0 && pos[0] < r1 + s2 &&
+      pos[0] < r2 + s1)
+    return false;
+  int n12 = 0;
+  for (uint t = 0; t < pos[0]; t++)
+    if (s->colors[s->cons_cells[s->cons_start[k] + pos[1 + t]]] == EMPTY)
+      n12++;
+  if (n12 == 0) return false;
+  int n1 = s->cons_empty[k] - n12, n2 = s->cons_empty[k2] - n12;
+  int lo = 0, hi = n12;
+  if (r1 - n1 > lo) lo = r1 - n1;
+  if (r2 - n2 > lo) lo = r2 - n2;
+  if (r1 < hi) hi = r1;
+  if (r2 < hi) hi = r2;
+  return lo > hi || hi == 0 || lo == n12 ||
+         (n1 > 0 && (r1 == lo || r1 - hi == n1)) ||
+         (n2 > 0 && (r2 == lo || r2 - hi == n2));
+}
+
+/* ************************************************************************** */
+
+/* Gets the color forced by a pair on cell x, a cell of its first constraint if
+ * in_k, or else of its second one (EMPTY if none). */
+static color _pair_color(const logic* l, const pair_colors* pc, uint x,
+                         bool in_k) {
+  if (l->s->colors[x] != EMPTY) return EMPTY;
+  if (l->stamp[x] == pc->shared) return pc->c12;
+  if (in_k) return pc->c1;
+  return (l->stamp[x] == pc->only2) ? pc->c2 : EMPTY;
+}
+
+/* ************************************************************************** */
+
+/* Applies the pair rule on constraints k and k2. Sets *forced if cells are
+ * deduced, and returns false on a contradiction. */
+static bool _pair(logic* l, uint k, uint k2, bool* forced) {
+  solver* s = l->s;
+  pair_colors pc;
+  if (!_pair_colors(l, k, k2, &pc)) return false;
+  for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+    color c = _pair_color(l, &pc, s->cons_cells[p], true);
+    if (c == EMPTY) continue;
+    *forced = true;
+    if (!_deduce(l, s->cons_cells[p], c, RULE_PAIR, k, k2)) return false;
+  }
+  for (uint p = s->cons_start[k2]; p < s->cons_start[k2 + 1]; p++) {
+    color c = _pair_color(l, &pc, s->cons_cells[p], false);
+    if (c == EMPTY) continue;
+    *forced = true;
+    if (!_deduce(l, s->cons_cells[p], c, RULE_PAIR, k2, k)) return false;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Applies the pair rule to the dirty constraints and their overlapping ones,
+ * until a pair forces cells. A pair of two dirty constraints is checked with
+ * the last one. */
+static bool _pairs(logic* l, bool* forced) {
+  solver* s = l->s;
+  while (l->nb_dirty > 0) {
+    uint k = l->dirty[--l->nb_dirty];
+    l->is_dirty[k] = false;
+    if (s->cons_empty[k] == 0) continue;
+    for (uint r = s->pair_start[k]; r < s->pair_start[k + 1]; r++) {
+      uint k2 = s->pair_cons[r];
+      if (s->cons_empty[k2] == 0 || l->is_dirty[k2]) continue;  // done later
+      if (!_pair_may_force(s, k, r)) continue;
+      if (!_pair(l, k, k2, forced)) return false;
+      if (*forced) {
+        _set_dirty(l, k);  // its other pairs are still to be checked
+        return true;
+      }
+    }
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Applies the saturation and pair rules until nothing more is deduced, the
+ * saturation rule first. */
+static bool _propagate(logic* l) {
+  while (true) {
+    if (!_saturated(l)) return false;
+    bool forced = false;
+    if (!_pairs(l, &forced)) return false;
+    if (!forced) return true;
+  }
+}
+
+/* ************************************************************************** */
+
+/* Marks the colors assigned by a chain try without contradiction, from
+ * trail position mark on, as safe: their cells watch the constraints of all
+ * the assigned cells. */
+static void _watch_try(logic* l, uint mark) {
+  solver* s = l->s;
+  uint epoch = ++l->epoch, nb = 0;
+  for (uint t = mark; t < s->trail_size; t++) {
+    uint y = s->trail[t];
+    for (uint p = s->cell_start[y]; p < s->cell_start[y + 1]; p++) {
+      uint k = s->cell_cons[p];
+      if (l->seen[k] == epoch) continue;
+      l->seen[k] = epoch;
+      l->touched[nb++] = k;
+    }
+  }
+  for (uint t = mark; t < s->trail_size; t++) {
+    uint y = s->trail[t];
+    if (l->safe[y] & (1u << s->colors[y])) continue;
+    l->safe[y] |= 1u << s->colors[y];
+    for (uint i = 0; i < nb; i++) _watch(l, l->touched[i], y);
+  }
+}
+
+/* ************************************************************************** */
+
+/* Tries the colors of the empty constrained cells that are not safe, from
+ * chain_pos: if the simpler rules lead one of them to a contradiction, the
+ * cell takes the other one. Sets *forced if a cell is deduced. */
+static bool _chain(logic* l, bool* forced) {
+  solver* s = l->s;
+  if (!l->safe) {
+    l->safe = (uint8_t*)calloc(s->nb_cells + 1, sizeof(uint8_t));
+    l->watch = (watch_list*)calloc(s->nb_cons + 1, sizeof(watch_list));
+    l->touched = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+    l->seen = (uint*)calloc(s->nb_cons + 1, sizeof(uint));
+    assert(l->safe && l->watch && l->touched && l->seen);
+  }
+  for (uint t = 0; t < s->nb_cells; t++) {
+    uint x = (l->chain_pos + t) % s->nb_cells;
+    if (s->colors[x] != EMPTY || solver_is_free(s, x)) continue;
+    for (color c = WHITE; c <= BLACK; c++) {
+      if (l->safe[x] & (1u << c)) continue;
+      uint mark = solver_mark(s);
+      l->recording = false;
+      bool ok = _deduce(l, x, c, RULE_CHAIN, 0, 0) && _propagate(l);
+      if (ok) _watch_try(l, mark);
+      solver_undo(s, mark);
+      _clear_dirty(l);
+      l->recording = true;
+      if (ok) continue;
+      l->chain_pos = x;
+      *forced = true;
+      uint k = l->conflict;
+      return _deduce(l, x, (c == WHITE) ? BLACK : WHITE, RULE_CHAIN, k, k);
+    }
+  }
+  return true;
+}
+
+/* Queues all the constraints for both rules. */
+static void _queue_all(logic* l) {
+  solver* s = l->s;
+  for (uint k = 0; k < s->nb_cons; k++) {
+    if (!s->queued[k]) {
+      s->queued[k] = true;
+      s->queue[s->queue_size++] = k;
+    }
+    _set_dirty(l, k);
+  }
+}
+
+/* ************************************************************************** */
+/*                                  LOGIC                                     */
+/* ************************************************************************** */
+
+difficulty game_solve_logic(game g, deduction** steps, uint* nb_steps) {
+  assert(g);
+  solver* s = solver_build(g, true, PROPAGATION_COUNT, NULL);
+  logic l;
+  _init(&l, s);
+
+  // the trivial clues first, then the tiers from the simplest one, going
+  // back to the simplest one after each deduction
+  bool ok = !s->conflict && _trivial(&l);
+  if (ok) _queue_all(&l);
+  while (ok) {
+    ok = _propagate(&l);
+    bool forced = false;
+    if (ok) ok = _chain(&l, &forced);
+    if (!forced) break;
+  }
+
+  difficulty grade = DIFFICULTY_TRIVIAL;
+  for (uint t = 0; t < l.nb_steps; t++)
+    if ((difficulty)l.steps[t].rule > grade)
+      grade = (difficulty)l.steps[t].rule;
+  for (uint x = 0; x < s->nb_cells; x++)
+    if (s->colors[x] == EMPTY) grade = DIFFICULTY_UNSOLVED;
+  if (!ok)
+    grade = DIFFICULTY_UNSOLVED;
+  else
+    solver_export(s, g);
+
+  if (steps)
+    *steps = l.steps;
+  else
+    free(l.steps);
+  if (nb_steps) *nb_steps = l.nb_steps;
+  _free(&l);
+  solver_delete(s);
+  return grade;
+}
+
+/* ************************************************************************** */
+
+difficulty game_grade(cgame g) {
+  game h = game_copy(g);
+  difficulty grade = game_solve_logic(h, NULL, NULL);
+  game_delete(h);
+  return grade;
+}
+
+/* ************************************************************************** */
+/*                                  HINTS                                     */
+/* ************************************************************************** */
+
+hint_state hint_new(cgame g) {
+  assert(g);
+  hint_state h = (hint_state)calloc(1, sizeof(struct hint_s));
+  assert(h);
+  _init(&h->l, solver_build(g, true, PROPAGATION_COUNT, NULL));
+  _queue_all(&h->l);
+  return h;
+}
+
+/* ************************************************************************** */
+
+void hint_delete(hint_state h) {
+  if (!h) return;
+  _free(&h->l);
+  solver_delete(h->l.s);
+  free(h);
+}
+
+/* ************************************************************************** */
+
+/* Brings the solver up to date with the colors of the game: the constraints
+ * of the changed cells are queued for both rules. */
+static void _sync(logic* l, cgame g) {
+  solver* s = l->s;
+  assert(game_nb_rows(g) == s->nb_rows && game_nb_cols(g) == s->nb_cols);
+  for (uint i = 0; i < s->nb_rows; i++)
+    for (uint j = 0; j < s->nb_cols; j++) {
+      uint x = i * s->nb_cols + j;
+      color c = game_get_color(g, i, j);
+      if (c == s->colors[x]) continue;
+      if (s->colors[x] != EMPTY) solver_unassign(s, x);
+      if (c != EMPTY) solver_assign(s, x, c);
+      for (uint p = s->cell_start[x]; p < s->cell_start[x + 1]; p++)
+        _set_dirty(l, s->cell_cons[p]);
+    }
+}
+
+/* ************************************************************************** */
+
+bool hint_next(hint_state h, cgame g, deduction* d) {
+  assert(h && g && d);
+  logic* l = &h->l;
+  solver* s = l->s;
+  _sync(l, g);
+
+  // saturated clues: a constraint stays queued as long as it forces cells
+  while (s->queue_size > 0) {
+    uint k = s->queue[s->queue_size - 1];
+    if (_violated(s, k)) return false;
+    int need = s->cons_need[k], total = 0;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++)
+      total += s->cons_weights[p];
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] != EMPTY) continue;
+      int w = s->cons_weights[p];
+      color c = (s->cons_black[k] + w > need) ? WHITE
+                : (s->cons_black[k] + s->cons_empty[k] - w < need) ? BLACK
+                                                                    : EMPTY;
+      if (c == EMPTY) continue;
+      logic_rule rule =
+          (need == 0 || need == total) ? RULE_TRIVIAL : RULE_SATURATED;
+      _describe(s, d, x, c, rule, k, k);
+      return true;
+    }
+    s->queued[k] = false;
+    s->queue_size--;
+  }
+
+  // pairs of clues: a constraint stays dirty as long as one of its pairs
+  // forces cells
+  while (l->nb_dirty > 0) {
+    uint k = l->dirty[l->nb_dirty - 1];
+    for (uint r = s->pair_start[k]; r < s->pair_start[k + 1]; r++) {
+      uint k2 = s->pair_cons[r];
+      if (s->cons_empty[k] == 0 || s->cons_empty[k2] == 0) continue;
+      pair_colors pc;
+      if (!_pair_colors(l, k, k2, &pc)) return false;
+      for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+        color c = _pair_color(l, &pc, s->cons_cells[p], true);
+        if (c == EMPTY) continue;
+        _describe(s, d, s->cons_cells[p], c, RULE_PAIR, k, k2);
+        return true;
+      }
+      for (uint p = s->cons_start[k2]; p < s->cons_start[k2 + 1]; p++) {
+        color c = _pair_color(l, &pc, s->cons_cells[p], false);
+        if (c == EMPTY) continue;
+        _describe(s, d, s->cons_cells[p], c, RULE_PAIR, k2, k);
+        return true;
+      }
+    }
+    l->is_dirty[k] = false;
+    l->nb_dirty--;
+  }
+  return false;
+}
+
+/* ************************************************************************** */
+
+bool game_hint(cgame g, uint* i, uint* j, color* c, uint* clue_i,
+               uint* clue_j) {
+  hint_state h = hint_new(g);
+  deduction d;
+  bool found = hint_next(h, g, &d);
+  hint_delete(h);
+  if (!found) return false;
+  if (i) *i = d.i;
+  if (j) *j = d.j;
+  if (c) *c = d.c;
+  if (clue_i) *clue_i = d.clue_i;
+  if (clue_j) *clue_j = d.clue_j;
+  return true;
+}
+
+/* ************************************************************************** */
+/*                                DEAD ENDS                                   */
+/* ************************************************************************** */
+
+/* cells of a component charged as one search node before searching it: the
+ * extraction propagates the whole component, once per call */
+#define DEADEND_CELLS_PER_NODE 16
+
+/* Adds constraint k to the clues to explain, once. */
+static void _blame(uint* stack, uint* size, bool* seen, int k) {
+  if (k < 0 || seen[k]) return;
+  seen[k] = true;
+  stack[(*size)++] = k;
+}
+
+/* ************************************************************************** */
+
+/* Marks the squares of the clues to explain in core, and recursively the clues
+ * that deduced their colored cells: these clues and the colors of the player
+ * are enough to get the same contradiction. */
+static void _explain(const logic* l, uint* stack, uint size, bool* seen,
+                     bool* core) {
+  const solver* s = l->s;
+  while (size > 0) {
+    uint k = stack[--size];
+    core[s->cons_square[k]] = true;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] == EMPTY) continue;
+      _blame(stack, &size, seen, l->reason[x]);
+      _blame(stack, &size, seen, l->reason2[x]);
+    }
+  }
+}
+
+/* ************************************************************************** */
+
+/* Decides whether the colors of a solver, just built, can be completed: the
+ * rules up to the pairs first, then a search on each component, which uses the
+ * remaining budget of nodes, its extraction included. On a dead end, the
+ * squares of the clues involved are set in core. */
+static deadend_status _dead_end(solver* s, uint64_t* budget, bool* core) {
+  logic l;
+  _init(&l, s);
+  l.recording = false;
+  l.reason = (int*)malloc((s->nb_cells + 1) * sizeof(int));
+  l.reason2 = (int*)malloc((s->nb_cells + 1) * sizeof(int));
+  assert(l.reason && l.reason2);
+  for (uint x = 0; x < s->nb_cells; x++) l.reason[x] = l.reason2[x] = -1;
+  uint* stack = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  bool* seen = (bool*)calloc(s->nb_cons + 1, sizeof(bool));
+  assert(stack && seen);
+  uint size = 0;
+
+  // a clue already broken by the player
+  for (uint k = 0; k < s->nb_cons && s->conflict; k++)
+    if (_violated(s, k)) {
+      l.conflict = l.conflict2 = k;
+      break;
+    }
+  deadend_status status = DEADEND_NONE;
+  bool ok = !s->conflict && _trivial(&l);
+  if (ok) _queue_all(&l);
+  if (ok && !_propagate(&l)) ok = false;
+  if (!ok) {
+    status = DEADEND_FOUND;
+    _blame(stack, &size, seen, l.conflict);
+    _blame(stack, &size, seen, l.conflict2);
+  }
+
+  // search the components left, within the budget
+  uint* start = (uint*)malloc((s->nb_cells + 2) * sizeof(uint));
+  uint* cells = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(start && cells);
+  uint nb_comps = ok ? solver_split(s, start, cells) : 0;
+  for (uint c = 0; c < nb_comps && status == DEADEND_NONE; c++) {
+    uint nb = start[c + 1] - start[c];
+    if (solver_is_free(s, cells[start[c]])) continue;
+    uint64_t cost = nb / DEADEND_CELLS_PER_NODE;
+    if (*budget <= cost) {
+      status = DEADEND_UNKNOWN;
+      break;
+    }
+    *budget -= cost;
+    solver* t = solver_extract(s, cells + start[c], nb);
+    t->max_nodes = *budget;
+    bool found = solver_solve(t);
+    *budget = (t->nb_nodes < *budget) ? *budget - t->nb_nodes : 0;
+    if (!found && *budget == 0) {
+      status = DEADEND_UNKNOWN;  // stopped
+    } else if (!found) {
+      status = DEADEND_FOUND;
+      for (uint i = start[c]; i < start[c + 1]; i++)
+        for (uint p = s->cell_start[cells[i]]; p < s->cell_start[cells[i] + 1];
+             p++)
+          _blame(stack, &size, seen, s->cell_cons[p]);
+    }
+    solver_delete(t);
+  }
+  if (status == DEADEND_FOUND) _explain(&l, stack, size, seen, core);
+
+  free(start);
+  free(cells);
+  free(stack);
+  free(seen);
+  _free(&l);
+  return status;
+}
+
+/* ************************************************************************** */
+
+deadend_status game_dead_end(cgame g, uint64_t budget, uint** clues,
+                             uint* nb_clues) {
+  assert(g && clues && nb_clues);
+  uint nb_squares = game_nb_rows(g) * game_nb_cols(g);
+  bool* core = (bool*)calloc(nb_squares + 1, sizeof(bool));
+  bool* sub = (bool*)calloc(nb_squares + 1, sizeof(bool));
+  assert(core && sub);
+  solver* s = solver_build(g, true, PROPAGATION_TABLE, NULL);
+  color* colors = (color*)malloc((s->nb_cells + 1) * sizeof(color));
+  bool* keep = (bool*)malloc((s->nb_cons + 1) * sizeof(bool));
+  assert(colors && keep);
+  memcpy(colors, s->colors, s->nb_cells * sizeof(color));
+  deadend_status status = _dead_end(s, &budget, core);
+
+  // deletion-based minimization: a clue is dropped if the other ones are
+  // still a dead end, and the clues of the smaller dead end are kept; each
+  // subset is restricted from the first solver rather than built again from
+  // the whole grid
+  for (uint q = 0; q < nb_squares && status == DEADEND_FOUND; q++) {
+    if (!core[q]) continue;
+    core[q] = false;
+    memset(sub, 0, nb_squares * sizeof(bool));
+    for (uint k = 0; k < s->nb_cons; k++) keep[k] = core[s->cons_square[k]];
+    solver* t = solver_restrict(s, keep, colors);
+    deadend_status st = _dead_end(t, &budget, sub);
+    solver_delete(t);
+    if (st == DEADEND_FOUND) {
+      bool* tmp = core;
+      core = sub;
+      sub = tmp;
+    } else {
+      core[q] = true;
+    }
+    if (st == DEADEND_UNKNOWN) break;  // out of budget, the core stays valid
+  }
+
+  *nb_clues = 0;
+  *clues = NULL;
+  if (status == DEADEND_FOUND) {
+    for (uint q = 0; q < nb_squares; q++)
+      if (core[q]) (*nb_clues)++;
+    *clues = (uint*)malloc((*nb_clues + 1) * sizeof(uint));
+    assert(*clues);
+    uint n = 0;
+    for (uint q = 0; q < nb_squares; q++)
+      if (core[q]) (*clues)[n++] = q;
+  }
+  free(keep);
+  free(colors);
+  solver_delete(s);
+  free(core);
+  free(sub);
+  return status;
+}
+
+/* ************************************************************************** */
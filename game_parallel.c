@@ -0,0 +1,307 @@
+/**
+ * @file game_parallel.c
+ * @brief Work-stealing parallel search.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bigint.h"
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* A task is a subtree of the search, given by the decisions leading to it
+ * from the root (cell index * 2 + 1 if BLACK). */
+typedef struct {
+  uint depth;
+  uint moves[];
+} task;
+
+/* A double-ended queue of tasks: the owner pushes and pops at the bottom,
+ * thieves steal at the top (the oldest, and usually largest, subtrees). */
+typedef struct {
+  pthread_mutex_t lock;
+  task** tasks;
+  uint top, bottom, capacity;
+} deque;
+
+typedef struct pool_s pool;
+
+/* Per-thread data. */
+typedef struct {
+  pool* p;
+  uint id;
+  solver* s;       // private copy of the solver
+  deque dq;        // tasks of this thread
+  bigint* count;   // solutions counted by this thread
+  pthread_t thread;
+} worker;
+
+/* Data shared by all the threads. */
+struct pool_s {
+  uint nb_workers;
+  worker* workers;
+  uint split_depth;       // tasks shallower than this are split
+  bool first;             // true to stop at the first solution
+  bool stop;              // set when a solution is found (first mode)
+  long pending;           // tasks pushed but not completed yet
+  pthread_mutex_t lock;   // protects the solution
+  color* solution;        // first solution found
+};
+
+/* ************************************************************************** */
+/*                                  DEQUE                                     */
+/* ************************************************************************** */
+
+static void _deque_init(deque* dq) {
+  pthread_mutex_init(&dq->lock, NULL);
+  dq->capacity = 64;
+  dq->top = dq->bottom = 0;
+  dq->tasks = (task**)malloc(dq->capacity * sizeof(task*));
+  assert(dq->tasks);
+}
+
+/* ************************************************************************** */
+
+static void _deque_free(deque* dq) {
+  for (uint k = dq->top; k < dq->bottom; k++) free(dq->tasks[k]);
+  free(dq->tasks);
+  pthread_mutex_destroy(&dq->lock);
+}
+
+/* ************************************************************************** */
+
+static void _deque_push(deque* dq, task* t) {
+  pthread_mutex_lock(&dq->lock);
+  if (dq->bottom == dq->capacity) {
+    // compact, then grow if still full
+    uint size = dq->bottom - dq->top;
+    memmove(dq->tasks, dq->tasks + dq->top, size * sizeof(task*));
+    dq->top = 0;
+    dq->bottom = size;
+    if (size == dq->capacity) {
+      dq->capacity *= 2;
+      dq->tasks = (task**)realloc(dq->tasks, dq->capacity * sizeof(task*));
+      assert(dq->tasks);
+    }
+  }
+  dq->tasks[dq->bottom++] = t;
+  pthread_mutex_unlock(&dq->lock);
+}
+
+/* ************************************************************************** */
+
+static task* _deque_pop(deque* dq) {
+  task* t = NULL;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->bottom > dq->top) t = dq->tasks[--dq->bottom];
+  pthread_mutex_unlock(&dq->lock);
+  return t;
+}
+
+/* ************************************************************************** */
+
+static task* _deque_steal(deque* dq) {
+  task* t = NULL;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->bottom > dq->top) t = dq->tasks[dq->top++];
+  pthread_mutex_unlock(&dq->lock);
+  return t;
+}
+
+/* ************************************************************************** */
+/*                                  TASKS                                     */
+/* ************************************************************************** */
+
+static task* _task_new(const task* parent, uint move) {
+  uint depth = parent ? parent->depth + 1 : 0;
+  task* t = (task*)malloc(sizeof(task) + (depth + 1) * sizeof(uint));
+  assert(t);
+  t->depth = depth;
+  if (parent) {
+    memcpy(t->moves, parent->moves, parent->depth * sizeof(uint));
+    t->moves[depth - 1] = move;
+  }
+  return t;
+}
+
+/* ************************************************************************** */
+
+static void _push_task(worker* w, task* t) {
+  __atomic_add_fetch(&w->p->pending, 1, __ATOMIC_SEQ_CST);
+  _deque_push(&w->dq, t);
+}
+
+/* ************************************************************************** */
+
+static task* _get_task(worker* w) {
+  task* t = _deque_pop(&w->dq);
+  for (uint k = 1; k < w->p->nb_workers && t == NULL; k++)
+    t = _deque_steal(&w->p->workers[(w->id + k) % w->p->nb_workers].dq);
+  return t;
+}
+
+/* ************************************************************************** */
+
+/* Replays the decisions of a task, then splits it or searches its subtree. */
+static void _run_task(worker* w, task* t) {
+  pool* p = w->p;
+  solver* s = w->s;
+  uint mark = solver_mark(s), pos = s->free_pos;
+  bool ok = true;
+  for (uint d = 0; d < t->depth && ok; d++) {
+    uint x = t->moves[d] / 2;
+    color c = (t->moves[d] % 2) ? BLACK : WHITE;
+    ok = (s->colors[x] == c) ||
+         (s->colors[x] == EMPTY && solver_assign(s, x, c) &&
+          solver_propagate(s));
+  }
+
+  if (ok) {
+    uint x = solver_choose(s);
+    if (x == s->nb_cells) {
+      // the decisions already lead to a solution
+      if (p->first) {
+        pthread_mutex_lock(&p->lock);
+        if (!p->stop)
+          memcpy(p->solution, s->colors, s->nb_cells * sizeof(color));
+        __atomic_store_n(&p->stop, true, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&p->lock);
+      } else {
+        bigint* one = bigint_new(1);
+        bigint_add(w->count, one);
+        bigint_free(one);
+      }
+    } else if (t->depth < p->split_depth && !solver_is_free(s, x)) {
+      // split on a constrained cell: the WHITE branch is popped first
+      s->nb_nodes += 2;
+      _push_task(w, _task_new(t, 2 * x + 1));
+      _push_task(w, _task_new(t, 2 * x));
+    } else if (p->first) {
+      if (solver_solve(s)) {
+        pthread_mutex_lock(&p->lock);
+        if (!p->stop)
+          memcpy(p->solution, s->colors, s->nb_cells * sizeof(color));
+        __atomic_store_n(&p->stop, true, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&p->lock);
+      }
+    } else {
+      bigint* nb = bigint_new(solver_count(s));
+      bigint_add(w->count, nb);
+      bigint_free(nb);
+    }
+  }
+
+  solver_undo(s, mark);
+  s->free_pos = pos;
+  free(t);
+  __atomic_sub_fetch(&p->pending, 1, __ATOMIC_SEQ_CST);
+}
+
+/* ************************************************************************** */
+
+static void* _worker_main(void* arg) {
+  worker* w = (worker*)arg;
+  pool* p = w->p;
+  while (!__atomic_load_n(&p->stop, __ATOMIC_SEQ_CST)) {
+    task* t = _get_task(w);
+    if (t) {
+      _run_task(w, t);
+    } else if (__atomic_load_n(&p->pending, __ATOMIC_SEQ_CST) == 0) {
+      break;  // no more work anywhere
+    } else {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+/* ************************************************************************** */
+
+/* Runs the pool of workers from the current state of the solver. */
+static void _run_pool(solver* s, uint nb_threads, bool first, color* solution,
+                      bigint* count) {
+  pool p;
+  p.nb_workers = nb_threads;
+  p.first = first;
+  p.stop = false;
+  p.pending = 0;
+  p.solution = solution;
+  pthread_mutex_init(&p.lock, NULL);
+
+  // about 64 tasks per thread
+  p.split_depth = 6;
+  for (uint n = 1; n < nb_threads; n *= 2) p.split_depth++;
+
+  p.workers = (worker*)malloc(nb_threads * sizeof(worker));
+  assert(p.workers);
+  for (uint k = 0; k < nb_threads; k++) {
+    worker* w = &p.workers[k];
+    w->p = &p;
+    w->id = k;
+    w->s = solver_copy(s);
+    w->s->stop = first ? &p.stop : NULL;
+    w->count = bigint_new(0);
+    _deque_init(&w->dq);
+  }
+  _push_task(&p.workers[0], _task_new(NULL, 0));
+
+  for (uint k = 0; k < nb_threads; k++)
+    pthread_create(&p.workers[k].thread, NULL, _worker_main, &p.workers[k]);
+  for (uint k = 0; k < nb_threads; k++)
+    pthread_join(p.workers[k].thread, NULL);
+
+  uint64_t nb_nodes = s->nb_nodes, nb_probes = s->nb_probes;
+  for (uint k = 0; k < nb_threads; k++) {
+    worker* w = &p.workers[k];
+    if (count) bigint_add(count, w->count);
+    s->nb_nodes += w->s->nb_nodes - nb_nodes;  // the copies started from s
+    s->nb_probes += w->s->nb_probes - nb_probes;
+    bigint_free(w->count);
+    solver_delete(w->s);
+    _deque_free(&w->dq);
+  }
+  free(p.workers);
+  pthread_mutex_destroy(&p.lock);
+}
+
+/* ************************************************************************** */
+/*                             PARALLEL ENGINE                                */
+/* ************************************************************************** */
+
+bool parallel_solve(solver* s, uint nb_threads) {
+  if (s->conflict) return false;
+  color* solution = (color*)malloc((s->nb_cells + 1) * sizeof(color));
+  assert(solution);
+  for (uint x = 0; x < s->nb_cells; x++) solution[x] = EMPTY;
+  _run_pool(s, nb_threads, true, solution, NULL);
+
+  // replay the solution on the solver
+  bool found = (s->nb_cells == 0 || solution[0] != EMPTY);
+  for (uint x = 0; x < s->nb_cells && found; x++)
+    if (s->colors[x] == EMPTY) solver_assign(s, x, solution[x]);
+  free(solution);
+  return found;
+}
+
+/* ************************************************************************** */
+
+bigint* parallel_count(solver* s, uint nb_threads) {
+  bigint* count = bigint_new(0);
+  if (!s->conflict) _run_pool(s, nb_threads, false, NULL, count);
+  return count;
+}
+
+/* ************************************************************************** */
@@ -39,6 +39,17 @@ typedef struct move_s move;
 /* ************************************************************************** */
 
 #define MAX(x, y) ((x > (y)) ? (x) : (y))
+#define MIN(x, y) ((x < (y)) ? (x) : (y))
+
+/* ************************************************************************** */
+/*                             NEIGHBOURHOOD                                  */
+/* ************************************************************************** */
+
+/** directions to explore for each kind of neighbourhood (see game.c) */
+extern direction* DIR_ARRAYS[];
+
+/** number of directions to explore for each kind of neighbourhood */
+extern uint DIR_SIZES[];
 
 /* ************************************************************************** */
 /*                             STACK ROUTINES                                 */
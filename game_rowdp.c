@@ -0,0 +1,666 @@
+/**
+ * @file game_rowdp.c
+ * @brief Row-profile dynamic programming to count solutions.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bigint.h"
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+#define EMPTY_KEY UINT64_MAX
+
+/* maximal number of bits of a key (the last one is never set, so that no key
+ * is EMPTY_KEY) */
+#define MAX_KEY_BITS 63
+
+/* maximal number of states of a table, beyond which the sweep gives up (the
+ * component engines are then much faster) */
+#define MAX_STATES (1u << 20)
+
+/* Hashed table of states: each key is a coloring of the cells kept in the
+ * state, and each value is a counter of nb_limbs 32-bit limbs. The cells kept
+ * for a few steps form a shifting window in the low bits (bit t for the t-th
+ * last free cell), and the cells kept for long (e.g. the first lines of a
+ * wrapping grid, needed again around the seam) are pinned in fixed slots in
+ * the high bits (bit 63 - k for slot k). */
+typedef struct {
+  uint64_t* keys;
+  uint32_t* counts;
+  uint capacity;
+  uint size;
+  uint nb_limbs;
+} dp_table;
+
+/* A constraint check at the current cell: the weighted number of black cells
+ * in the window, sum(weight[g] * popcount(key & mask[g])), must lie in
+ * [lo, hi]. */
+typedef struct {
+  uint nb_groups;
+  uint64_t mask[9];
+  int weight[9];
+  int lo, hi;
+} dp_check;
+
+/* Sweep order of the cells, and free cells of the current sweep. */
+typedef struct {
+  solver* s;
+  uint width;       // number of cells per line
+  uint nb_lines;    // number of lines
+  uint* order;      // position -> cell
+  uint* pos;        // cell -> position
+  uint* fidx;       // position -> number of free cells before it
+  uint* fpos;       // free index -> position
+  uint64_t* keeps;  // free index -> bits kept after this cell
+  uint64_t* pins;   // free index -> bit of the slot of the cell if pinned,
+                    // 0 otherwise
+  uint64_t wmask;   // bits of the shifting window
+  uint nb_free;     // number of free cells
+  bigint** black;   // if not NULL, cell -> number of solutions with the cell
+                    // black
+  zdd* z;           // if not NULL, store of the compiled diagram
+  uint root;        // diagram of the sweep
+} rowdp;
+
+/* ************************************************************************** */
+/*                               HASH TABLE                                   */
+/* ************************************************************************** */
+
+static inline uint _hash(uint64_t key, uint capacity) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return (uint)(key & (capacity - 1));
+}
+
+/* ************************************************************************** */
+
+static void _table_reset(dp_table* t, uint capacity, uint nb_limbs) {
+  free(t->keys);
+  free(t->counts);
+  t->capacity = capacity;
+  t->size = 0;
+  t->nb_limbs = nb_limbs;
+  t->keys = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+  t->counts = (uint32_t*)calloc((size_t)capacity * nb_limbs, sizeof(uint32_t));
+  assert(t->keys && t->counts);
+  for (uint k = 0; k < capacity; k++) t->keys[k] = EMPTY_KEY;
+}
+
+/* ************************************************************************** */
+
+static void _table_free(dp_table* t) {
+  free(t->keys);
+  free(t->counts);
+  t->keys = NULL;
+  t->counts = NULL;
+}
+
+/* ************************************************************************** */
+
+static void _table_add(dp_table* t, uint64_t key, const uint32_t* count,
+                       uint nb_limbs);
+
+static void _table_grow(dp_table* t) {
+  dp_table old = *t;
+  t->keys = NULL;
+  t->counts = NULL;
+  _table_reset(t, 2 * old.capacity, old.nb_limbs);
+  for (uint k = 0; k < old.capacity; k++)
+    if (old.keys[k] != EMPTY_KEY)
+      _table_add(t, old.keys[k], old.counts + (size_t)k * old.nb_limbs,
+                 old.nb_limbs);
+  _table_free(&old);
+}
+
+/* ************************************************************************** */
+
+/* add a counter of nb_limbs limbs (nb_limbs <= t->nb_limbs) to a state */
+static void _table_add(dp_table* t, uint64_t key, const uint32_t* count,
+                       uint nb_limbs) {
+  if (2 * (t->size + 1) > t->capacity) _table_grow(t);
+  uint h = _hash(key, t->capacity);
+  while (t->keys[h] != EMPTY_KEY && t->keys[h] != key)
+    h = (h + 1) & (t->capacity - 1);
+  if (t->keys[h] == EMPTY_KEY) {
+    t->keys[h] = key;
+    t->size++;
+  }
+  uint32_t* dst = t->counts + (size_t)h * t->nb_limbs;
+  uint64_t carry = 0;
+  for (uint l = 0; l < t->nb_limbs; l++) {
+    uint64_t sum = carry + dst[l] + (l < nb_limbs ? count[l] : 0);
+    dst[l] = (uint32_t)sum;
+    carry = sum >> 32;
+  }
+  assert(carry == 0);
+}
+
+/* ************************************************************************** */
+
+/* number of limbs actually used by the counters of a table */
+static uint _table_used_limbs(const dp_table* t) {
+  uint used = 1;
+  for (uint h = 0; h < t->capacity; h++) {
+    if (t->keys[h] == EMPTY_KEY) continue;
+    const uint32_t* count = t->counts + (size_t)h * t->nb_limbs;
+    for (uint l = t->nb_limbs; l > used; l--)
+      if (count[l - 1] != 0) {
+        used = l;
+        break;
+      }
+  }
+  return used;
+}
+
+/* Looks up a state, returns its slot or t->capacity if absent. */
+static uint _table_find(const dp_table* t, uint64_t key) {
+  uint h = _hash(key, t->capacity);
+  while (t->keys[h] != EMPTY_KEY) {
+    if (t->keys[h] == key) return h;
+    h = (h + 1) & (t->capacity - 1);
+  }
+  return t->capacity;
+}
+
+/* ************************************************************************** */
+
+static void _table_copy(dp_table* dst, const dp_table* src) {
+  *dst = *src;
+  size_t nb_counts = (size_t)src->capacity * src->nb_limbs;
+  dst->keys = (uint64_t*)malloc(src->capacity * sizeof(uint64_t));
+  dst->counts = (uint32_t*)malloc(nb_counts * sizeof(uint32_t));
+  assert(dst->keys && dst->counts);
+  memcpy(dst->keys, src->keys, src->capacity * sizeof(uint64_t));
+  memcpy(dst->counts, src->counts, nb_counts * sizeof(uint32_t));
+}
+
+/* ************************************************************************** */
+/*                                LIMBS                                       */
+/* ************************************************************************** */
+
+/* dst += src, on n limbs */
+static void _limbs_add(uint32_t* dst, const uint32_t* src, uint n) {
+  uint64_t carry = 0;
+  for (uint l = 0; l < n; l++) {
+    uint64_t sum = carry + dst[l] + src[l];
+    dst[l] = (uint32_t)sum;
+    carry = sum >> 32;
+  }
+  assert(carry == 0);
+}
+
+/* ************************************************************************** */
+
+/* acc += a * b, on n limbs (the caller knows that the sum fits) */
+static void _limbs_mul_add(uint32_t* acc, uint n, const uint32_t* a, uint na,
+                           const uint32_t* b, uint nb) {
+  while (na > 0 && a[na - 1] == 0) na--;
+  while (nb > 0 && b[nb - 1] == 0) nb--;
+  for (uint i = 0; i < na; i++) {
+    if (a[i] == 0) continue;
+    uint64_t carry = 0;
+    for (uint j = 0; i + j < n && (j < nb || carry != 0); j++) {
+      uint64_t t = (j < nb ? (uint64_t)a[i] * b[j] : 0) + acc[i + j] + carry;
+      acc[i + j] = (uint32_t)t;
+      carry = t >> 32;
+    }
+  }
+}
+
+/* ************************************************************************** */
+/*                                  SWEEP                                     */
+/* ************************************************************************** */
+
+/* Returns the bit of the g-th free cell in the keys after the f-th one. */
+static inline uint64_t _bit(const rowdp* d, uint f, uint g) {
+  return d->pins[g] ? d->pins[g] : (uint64_t)1 << (f - g);
+}
+
+/* ************************************************************************** */
+
+/* Extends a key with the color b of the f-th free cell: the window is
+ * shifted, and the color goes in bit 0, or in the slot of the cell if it is
+ * pinned. */
+static inline uint64_t _extend(const rowdp* d, uint f, uint64_t key,
+                               uint64_t b) {
+  uint64_t next = ((key & d->wmask) << 1) | (key & ~d->wmask);
+  if (d->pins[f]) return b ? next | d->pins[f] : next;
+  return next | b;
+}
+
+/* ************************************************************************** */
+
+/* Computes the constraint checks at the free cell of position p. */
+static uint _checks(const rowdp* d, uint p, dp_check* checks) {
+  solver* s = d->s;
+  uint x = d->order[p];
+  uint f = d->fidx[p];
+  uint nb_checks = 0;
+  for (uint q = s->cell_start[x]; q < s->cell_start[x + 1]; q++) {
+    uint k = s->cell_cons[q];
+    dp_check* c = &checks[nb_checks++];
+    c->nb_groups = 0;
+    int remaining = 0;
+    for (uint m = s->cons_start[k]; m < s->cons_start[k + 1]; m++) {
+      uint y = s->cons_cells[m];
+      int w = s->cons_weights[m];
+      if (s->colors[y] != EMPTY) continue;
+      if (d->pos[y] > p) {
+        remaining += w;
+        continue;
+      }
+      uint gr = 0;
+      while (gr < c->nb_groups && c->weight[gr] != w) gr++;
+      if (gr == c->nb_groups) {
+        c->nb_groups++;
+        c->weight[gr] = w;
+        c->mask[gr] = 0;
+      }
+      c->mask[gr] |= _bit(d, f, d->fidx[d->pos[y]]);
+    }
+    c->hi = s->cons_need[k] - s->cons_black[k];
+    c->lo = c->hi - remaining;
+  }
+  return nb_checks;
+}
+
+/* ************************************************************************** */
+
+/* Tests a new state (extended with the color of the current cell) against
+ * the checks of the current cell. */
+static bool _allowed(const dp_check* checks, uint nb_checks, uint64_t key) {
+  for (uint c = 0; c < nb_checks; c++) {
+    int nb_black = 0;
+    for (uint gr = 0; gr < checks[c].nb_groups; gr++)
+      nb_black += checks[c].weight[gr] *
+                  __builtin_popcountll(key & checks[c].mask[gr]);
+    if (nb_black < checks[c].lo || nb_black > checks[c].hi) return false;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* Sweeps the f-th free cell: the states of cur are extended with both colors
+ * of the cell into next. */
+static void _step(const rowdp* d, uint f, const dp_table* cur,
+                  dp_table* next) {
+  dp_check checks[16];
+  uint nb_checks = _checks(d, d->fpos[f], checks);
+  uint64_t keep = d->keeps[f];
+
+  // a new counter is the sum of at most 2 * cur->size old ones, so one more
+  // limb is enough as long as there are less than 2^31 states
+  uint nb_limbs = _table_used_limbs(cur) + 1;
+  uint capacity = 16;
+  while (capacity < 4 * cur->size) capacity *= 2;
+  _table_reset(next, capacity, nb_limbs);
+  for (uint h = 0; h < cur->capacity; h++) {
+    if (cur->keys[h] == EMPTY_KEY) continue;
+    const uint32_t* count = cur->counts + (size_t)h * cur->nb_limbs;
+    for (uint64_t b = 0; b <= 1; b++) {
+      uint64_t key = _extend(d, f, cur->keys[h], b);
+      if (_allowed(checks, nb_checks, key))
+        _table_add(next, key & keep, count, cur->nb_limbs);
+    }
+  }
+}
+
+/* ************************************************************************** */
+
+/* Prefixes a diagram with the black constants of the positions [p0, p1). */
+static uint _constants(const rowdp* d, uint p0, uint p1, uint node) {
+  for (uint p = p1; p > p0 && node != ZDD_FALSE; p--)
+    if (d->s->colors[d->order[p - 1]] == BLACK)
+      node = zdd_node(d->z, p - 1, ZDD_FALSE, node);
+  return node;
+}
+
+/* ************************************************************************** */
+
+/* Sweeps the free cells backward from the table after the last one (tn,
+ * moved in): beta is the number of completions of each state, and the
+ * completions of the states with the cell black, times their counts, are the
+ * solutions with the cell black. Only the tables of sqrt(nb_free) checkpoints
+ * are kept by the forward sweep (moved in too): the ones between them are
+ * computed again, one segment at a time. Adds the counts to d->black, or if
+ * d->z is set, builds instead the diagram node of the completions of each
+ * state, and returns the one of the initial state. */
+static uint _backward(rowdp* d, dp_table* saved, uint period, dp_table tn,
+                      uint nb_limbs) {
+  uint n = d->s->nb_cells;
+  uint32_t* acc = (uint32_t*)malloc(nb_limbs * sizeof(uint32_t));
+  uint32_t* beta_next = NULL;
+  uint* ids_next = NULL;
+  dp_table* tabs = (dp_table*)calloc(period, sizeof(dp_table));
+  assert(acc && tabs);
+  if (d->z) {
+    ids_next = (uint*)malloc(tn.capacity * sizeof(uint));
+    assert(ids_next);
+    ids_next[_table_find(&tn, 0)] = ZDD_TRUE;
+  } else {
+    beta_next =
+        (uint32_t*)calloc((size_t)tn.capacity * nb_limbs, sizeof(uint32_t));
+    assert(beta_next);
+    beta_next[(size_t)_table_find(&tn, 0) * nb_limbs] = 1;
+  }
+
+  for (uint seg = (d->nb_free - 1) / period + 1; seg > 0; seg--) {
+    uint f0 = (seg - 1) * period;
+    uint f1 = (f0 + period < d->nb_free) ? f0 + period : d->nb_free;
+    tabs[0] = saved[seg - 1];
+    for (uint f = f0; f + 1 < f1; f++)
+      _step(d, f, &tabs[f - f0], &tabs[f - f0 + 1]);
+
+    for (uint f = f1; f > f0; f--) {
+      dp_table* t = &tabs[f - 1 - f0];
+      uint p = d->fpos[f - 1];
+      uint p_next = (f < d->nb_free) ? d->fpos[f] : n;
+      dp_check checks[16];
+      uint nb_checks = _checks(d, p, checks);
+      uint32_t* beta = NULL;
+      uint* ids = NULL;
+      if (d->z) {
+        ids = (uint*)malloc(t->capacity * sizeof(uint));
+        assert(ids);
+      } else {
+        beta = (uint32_t*)calloc((size_t)t->capacity * nb_limbs,
+                                 sizeof(uint32_t));
+        assert(beta);
+      }
+      memset(acc, 0, nb_limbs * sizeof(uint32_t));
+      for (uint h = 0; h < t->capacity; h++) {
+        if (t->keys[h] == EMPTY_KEY) continue;
+        uint child[2] = {ZDD_FALSE, ZDD_FALSE};
+        for (uint64_t b = 0; b <= 1; b++) {
+          uint64_t key = _extend(d, f - 1, t->keys[h], b);
+          if (!_allowed(checks, nb_checks, key)) continue;
+          uint h2 = _table_find(&tn, key & d->keeps[f - 1]);
+          if (d->z) {
+            child[b] = _constants(d, p + 1, p_next, ids_next[h2]);
+            continue;
+          }
+          const uint32_t* bn = beta_next + (size_t)h2 * nb_limbs;
+          _limbs_add(beta + (size_t)h * nb_limbs, bn, nb_limbs);
+          if (b == 1)
+            _limbs_mul_add(acc, nb_limbs, t->counts + (size_t)h * t->nb_limbs,
+                           t->nb_limbs, bn, nb_limbs);
+        }
+        if (d->z) ids[h] = zdd_node(d->z, p, child[0], child[1]);
+      }
+      if (!d->z) {
+        bigint* nb = bigint_new_limbs(acc, nb_limbs);
+        bigint_add(d->black[d->order[p]], nb);
+        bigint_free(nb);
+      }
+      _table_free(&tn);
+      free(beta_next);
+      free(ids_next);
+      tn = *t;
+      *t = (dp_table){0};
+      beta_next = beta;
+      ids_next = ids;
+    }
+  }
+
+  uint root = d->z ? ids_next[_table_find(&tn, 0)] : ZDD_FALSE;
+  _table_free(&tn);
+  free(beta_next);
+  free(ids_next);
+  free(tabs);
+  free(acc);
+  return root;
+}
+
+/* ************************************************************************** */
+
+/* Chooses the pinned cells: the free cells kept for more than t steps, for
+ * the t that gives the fewest key bits (the widest window left, plus the
+ * most cells pinned at the same time, as a slot is reused once its cell is
+ * released). Sets d->pins and d->wmask, and returns false if the keys do not
+ * fit in MAX_KEY_BITS bits. */
+static bool _pin(rowdp* d, const int* release) {
+  uint nb = d->nb_free;
+  uint* dist = (uint*)malloc((nb + 1) * sizeof(uint));
+  int* delta = (int*)malloc((nb + 2) * sizeof(int));
+  assert(dist && delta);
+  for (uint f = 0; f < nb; f++)
+    dist[f] = d->fidx[release[d->fpos[f]]] - f;
+
+  uint best_t = 0, best_bits = UINT32_MAX;
+  for (uint t = 0; t < MAX_KEY_BITS; t++) {
+    uint max_dist = 0;
+    memset(delta, 0, (nb + 2) * sizeof(int));
+    for (uint f = 0; f < nb; f++) {
+      if (dist[f] <= t) {
+        if (dist[f] > max_dist) max_dist = dist[f];
+        continue;
+      }
+      delta[f]++;
+      delta[f + dist[f] + 1]--;
+    }
+    int nb_pinned = 0, max_pinned = 0;
+    for (uint f = 0; f < nb; f++) {
+      nb_pinned += delta[f];
+      if (nb_pinned > max_pinned) max_pinned = nb_pinned;
+    }
+    uint bits = max_dist + 1 + max_pinned;
+    if (bits < best_bits) {
+      best_bits = bits;
+      best_t = t;
+    }
+  }
+
+  // the slots are given greedily, in the order of the cells
+  bool fits = best_bits <= MAX_KEY_BITS;
+  uint slot_end[MAX_KEY_BITS];  // last step of the cell in each slot
+  uint nb_slots = 0;
+  for (uint f = 0; f < nb && fits; f++) {
+    d->pins[f] = 0;
+    if (dist[f] <= best_t) continue;
+    uint k = 0;
+    while (k < nb_slots && slot_end[k] >= f) k++;
+    if (k == nb_slots) nb_slots++;
+    slot_end[k] = f + dist[f];
+    d->pins[f] = (uint64_t)1 << (63 - k);
+  }
+  d->wmask = UINT64_MAX >> nb_slots;
+  free(dist);
+  free(delta);
+  return fits;
+}
+
+/* ************************************************************************** */
+
+/* Runs the sweep with the current assignment of the solver: assigned cells are
+ * constants, and only the empty cells are enumerated. The count is added to
+ * res, the counts with each cell black to d->black if not NULL, and the
+ * diagram is set in d->root if d->z is not NULL. Returns false if the state
+ * is too wide, or if there are too many states. */
+static bool _rowdp_run(rowdp* d, bigint* res) {
+  solver* s = d->s;
+  uint n = s->nb_cells;
+
+  // free index of each position, and last free member of each constraint
+  d->fidx = (uint*)malloc((n + 1) * sizeof(uint));
+  d->fpos = (uint*)malloc((n + 1) * sizeof(uint));
+  d->keeps = (uint64_t*)malloc((n + 1) * sizeof(uint64_t));
+  d->pins = (uint64_t*)malloc((n + 1) * sizeof(uint64_t));
+  int* last = (int*)malloc((s->nb_cons + 1) * sizeof(int));
+  int* release = (int*)malloc((n + 1) * sizeof(int));
+  assert(d->fidx && d->fpos && d->keeps && d->pins && last && release);
+  d->nb_free = 0;
+  for (uint p = 0; p < n; p++) {
+    d->fidx[p] = d->nb_free;
+    if (s->colors[d->order[p]] == EMPTY) d->fpos[d->nb_free++] = p;
+  }
+  for (uint k = 0; k < s->nb_cons; k++) {
+    last[k] = -1;
+    for (uint q = s->cons_start[k]; q < s->cons_start[k + 1]; q++) {
+      uint x = s->cons_cells[q];
+      if (s->colors[x] == EMPTY && (int)d->pos[x] > last[k])
+        last[k] = d->pos[x];
+    }
+  }
+
+  // a free cell is kept in the state until its last constraint is complete
+  for (uint p = 0; p < n; p++) {
+    uint x = d->order[p];
+    release[p] = p;
+    if (s->colors[x] != EMPTY) continue;
+    for (uint q = s->cell_start[x]; q < s->cell_start[x + 1]; q++)
+      if (last[s->cell_cons[q]] > release[p]) release[p] = last[s->cell_cons[q]];
+  }
+  bool fits = _pin(d, release);
+
+  // cells kept after each free cell (the cells leaving the window are
+  // bucketed by release)
+  uint* rel_start = (uint*)calloc(n + 2, sizeof(uint));
+  uint* rel_cells = (uint*)malloc((n + 1) * sizeof(uint));
+  assert(rel_start && rel_cells);
+  for (uint p = 0; p < n; p++)
+    if (s->colors[d->order[p]] == EMPTY) rel_start[release[p] + 1]++;
+  for (uint p = 0; p < n; p++) rel_start[p + 1] += rel_start[p];
+  for (uint p = 0; p < n; p++)
+    if (s->colors[d->order[p]] == EMPTY) rel_cells[rel_start[release[p]]++] = p;
+  for (uint p = n; p > 0; p--) rel_start[p] = rel_start[p - 1];
+  rel_start[0] = 0;
+  uint64_t keep = 0;
+  for (uint f = 0; f < d->nb_free && fits; f++) {
+    uint p = d->fpos[f];
+    keep = _extend(d, f, keep, release[p] > (int)p);
+    for (uint r = rel_start[p]; r < rel_start[p + 1]; r++)
+      if (rel_cells[r] != p) keep &= ~_bit(d, f, d->fidx[rel_cells[r]]);
+    d->keeps[f] = keep;
+  }
+  free(rel_start);
+  free(rel_cells);
+  free(last);
+  free(release);
+
+  // the tables of the checkpoints are kept for the backward sweep
+  uint period = 1;
+  while (period * period < d->nb_free) period++;
+  dp_table* saved = NULL;
+  if ((d->black || d->z) && fits) {
+    saved = (dp_table*)calloc(d->nb_free / period + 1, sizeof(dp_table));
+    assert(saved);
+  }
+
+  dp_table cur = {0}, next = {0};
+  _table_reset(&cur, 16, 1);
+  uint32_t one = 1;
+  _table_add(&cur, 0, &one, 1);
+  for (uint f = 0; f < d->nb_free && cur.size > 0 && fits; f++) {
+    if (saved && f % period == 0) _table_copy(&saved[f / period], &cur);
+    _step(d, f, &cur, &next);
+    dp_table tmp = cur;
+    cur = next;
+    next = tmp;
+    if (cur.size > MAX_STATES) fits = false;
+  }
+
+  // all the cells have left the window: a single state remains
+  bigint* count = NULL;
+  for (uint h = 0; h < cur.capacity && fits; h++) {
+    if (cur.keys[h] == EMPTY_KEY) continue;
+    assert(cur.keys[h] == 0);
+    count = bigint_new_limbs(cur.counts + (size_t)h * cur.nb_limbs,
+                             cur.nb_limbs);
+    bigint_add(res, count);
+  }
+
+  if (d->black && count) {
+    for (uint x = 0; x < n; x++)
+      if (s->colors[x] == BLACK) bigint_add(d->black[x], count);
+  }
+  d->root = ZDD_FALSE;
+  if (d->z && count && d->nb_free == 0)
+    d->root = _constants(d, 0, n, ZDD_TRUE);
+  if (saved && count && d->nb_free > 0) {
+    uint root = _backward(d, saved, period, cur, _table_used_limbs(&cur));
+    if (d->z) d->root = _constants(d, 0, d->fpos[0], root);
+    cur = (dp_table){0};
+  } else if (saved) {
+    for (uint t = 0; t <= d->nb_free / period; t++) _table_free(&saved[t]);
+  }
+  bigint_free(count);
+
+  free(saved);
+  _table_free(&cur);
+  _table_free(&next);
+  free(d->fidx);
+  free(d->fpos);
+  free(d->keeps);
+  free(d->pins);
+  return fits;
+}
+
+/* ************************************************************************** */
+/*                             ROW DP ENGINE                                  */
+/* ************************************************************************** */
+
+/* Sets up the sweep order, and runs the sweeps. The sweep order is copied
+ * to order if not NULL. */
+static bigint* _rowdp(solver* s, bigint** black, zdd* z, uint* order) {
+  assert(!s->conflict);
+  rowdp d;
+  d.s = s;
+  d.black = black;
+  d.z = z;
+  d.root = ZDD_FALSE;
+  bool transposed = s->nb_cols > s->nb_rows;
+  d.width = transposed ? s->nb_rows : s->nb_cols;
+  d.nb_lines = transposed ? s->nb_cols : s->nb_rows;
+  d.order = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  d.pos = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(d.order && d.pos);
+  for (uint l = 0; l < d.nb_lines; l++)
+    for (uint k = 0; k < d.width; k++) {
+      uint p = l * d.width + k;
+      uint x = transposed ? k * s->nb_cols + l : l * s->nb_cols + k;
+      d.order[p] = x;
+      d.pos[x] = p;
+    }
+
+  bigint* res = bigint_new(0);
+  if (!_rowdp_run(&d, res)) {
+    bigint_free(res);
+    res = NULL;
+  }
+
+  if (order) memcpy(order, d.order, s->nb_cells * sizeof(uint));
+  if (z && res) z->root = d.root;
+  free(d.order);
+  free(d.pos);
+  return res;
+}
+
+/* ************************************************************************** */
+
+bigint* rowdp_count(solver* s) { return _rowdp(s, NULL, NULL, NULL); }
+
+/* ************************************************************************** */
+
+bigint* rowdp_marginals(solver* s, bigint** black) {
+  return _rowdp(s, black, NULL, NULL);
+}
+
+/* ************************************************************************** */
+
+bigint* rowdp_compile(solver* s, zdd* z, uint* order) {
+  return _rowdp(s, NULL, z, order);
+}
+
+/* ************************************************************************** */
@@ -3,9 +3,12 @@
 #include <SDL.h>
 #include <SDL_image.h>  // required to load transparent texture from PNG
 #include <SDL_ttf.h>    // required to use TTF fonts
+#include <inttypes.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "game.h"
@@ -70,6 +73,10 @@ void initiateButtons(Env *env) {
             env->startX + ((cols * square_size) / 2) + square_size * 1.5,
             env->startY - square_size / 2, square_size, square_size / 2.5);
 
+  SetButton(&env->hint, env->hint.name,
+            env->startX + ((cols * square_size) / 2) - square_size * 1.5,
+            env->startY - square_size / 2, square_size, square_size / 2.5);
+
   SetButton(
       &env->undo, env->undo.name,
       env->startX + ((cols * square_size) / 2) + square_size / 2,
@@ -87,6 +94,59 @@ void initiateButtons(Env *env) {
             square_size * 2, square_size);
 }
 
+// Marks the clues of a dead end, when the colors cannot lead to a solution
+void update_dead_end(Env *env) {
+  uint nb_squares = game_nb_rows(env->g) * game_nb_cols(env->g);
+  memset(env->dead_end, 0, nb_squares * sizeof(bool));
+  uint *clues, nb_clues;
+  if (game_dead_end(env->g, DEADEND_BUDGET, &clues, &nb_clues) ==
+      DEADEND_FOUND)
+    for (uint t = 0; t < nb_clues; t++) env->dead_end[clues[t]] = true;
+  free(clues);
+}
+
+// Computes the probability of each square to be black in a solution, for
+// the heatmap (NULL if the game has no solution or is too wide)
+double *compute_heat(cgame g) {
+  uint nb_squares = game_nb_rows(g) * game_nb_cols(g);
+  bigint **black = malloc(nb_squares * sizeof(bigint *));
+  checkNullPointer(black, "malloc black");
+  bigint *nb = game_nb_solutions_marginals(g, black);
+  double *heat = NULL;
+  if (nb && !bigint_is_zero(nb)) {
+    heat = malloc(nb_squares * sizeof(double));
+    checkNullPointer(heat, "malloc heat");
+    for (uint x = 0; x < nb_squares; x++)
+      heat[x] = bigint_to_double(black[x]) / bigint_to_double(nb);
+  }
+  for (uint x = 0; x < nb_squares && nb; x++) bigint_free(black[x]);
+  bigint_free(nb);
+  free(black);
+  return heat;
+}
+
+// Writes an estimate of the number of solutions, as "about 3.2e14"
+void format_estimate(const solution_estimate *est, char *text, size_t size) {
+  double l = est->log10_estimate;
+  if (l == -INFINITY && est->log10_high == INFINITY) {
+    snprintf(text, size, "unknown");
+  } else if (l == -INFINITY) {
+    snprintf(text, size, "about 0");
+  } else if (l < 6.0) {
+    snprintf(text, size, "about %.0f", pow(10.0, l));
+  } else {
+    int exponent = (int)floor(l);
+    double mantissa = pow(10.0, l - exponent);
+    if (mantissa >= 9.95) {
+      mantissa /= 10.0;
+      exponent++;
+    }
+    snprintf(text, size, "about %.1fe%d", mantissa, exponent);
+  }
+}
+
+/* **************************************************************** */
+
 Env *init(SDL_Window *win, SDL_Renderer *ren, int argc, char *argv[]) {
   Env *env = malloc(sizeof(struct Env_t));
 
@@ -103,9 +163,18 @@ Env *init(SDL_Window *win, SDL_Renderer *ren, int argc, char *argv[]) {
     env->g = game_random(5, 5, false, FULL, false, 0.7, 0.7);
   }
 
+  env->hints = hint_new(env->g);
+  env->dead_end = calloc(game_nb_rows(env->g) * game_nb_cols(env->g),
+                         sizeof(bool));
+  checkNullPointer(env->dead_end, "calloc dead_end");
+  update_dead_end(env);
+  env->heat = NULL;
+  env->estimated = false;
+
   setCords(env, winW, winH);
   SetButtonName(&env->nb_solutions, "Nb Solutions");
   SetButtonName(&env->solve, "Solve");
+  SetButtonName(&env->hint, "Hint");
   SetButtonName(&env->redo, "Redo");
   SetButtonName(&env->undo, "Undo");
   SetButtonName(&env->restart, "Restart");
@@ -166,6 +235,8 @@ void draw_constraint(SDL_Renderer *ren, int i, int j, Env *env) {
     SDL_Color textColor;
     if (game_get_status(env->g, i, j) == ERROR) {
       textColor = (SDL_Color){250, 16, 16, 255};
+    } else if (env->dead_end[i * game_nb_cols(env->g) + j]) {
+      textColor = (SDL_Color){250, 140, 16, 255};
     } else if (game_get_color(env->g, i, j) == BLACK) {
       textColor = (SDL_Color){247, 247, 247, 255};
     } else {
@@ -205,7 +276,14 @@ void draw_col_con(SDL_Renderer *ren, Env *env) {
           SDL_SetRenderDrawColor(ren, 10, 10, 10, SDL_ALPHA_OPAQUE);
           break;
         case EMPTY:
-          SDL_SetRenderDrawColor(ren, 165, 177, 199, SDL_ALPHA_OPAQUE);
+          if (env->heat) {
+            // from the empty color to dark, with the probability of black
+            double p = env->heat[i * game_nb_cols(env->g) + j];
+            SDL_SetRenderDrawColor(ren, 165 - 125 * p, 177 - 133 * p,
+                                   199 - 147 * p, SDL_ALPHA_OPAQUE);
+          } else {
+            SDL_SetRenderDrawColor(ren, 165, 177, 199, SDL_ALPHA_OPAQUE);
+          }
           break;
       }
       SDL_RenderFillRect(ren, &rect);
@@ -270,6 +348,8 @@ void render(SDL_Window *win, SDL_Renderer *ren, Env *env) {
               env->nb_solutions.name);
   draw_button(ren, env->solve.startX, env->solve.startY, env->solve.width,
               env->solve.height, env->solve.name);
+  draw_button(ren, env->hint.startX, env->hint.startY, env->hint.width,
+              env->hint.height, env->hint.name);
   draw_button(ren, env->undo.startX, env->undo.startY, env->undo.width,
               env->undo.height, env->undo.name);
   draw_button(ren, env->redo.startX, env->redo.startY, env->redo.width,
@@ -295,6 +375,14 @@ void updateButtonText(Env *env, struct Button_t *button, const char *newText,
 bool process(SDL_Window *win, SDL_Renderer *ren, Env *env, SDL_Event *e) {
   if (e->type == SDL_QUIT) {
     return true;
+  } else if (e->type == SDL_KEYDOWN && e->key.keysym.sym == SDLK_m) {
+    // show or hide the heatmap of the solutions
+    if (env->heat) {
+      free(env->heat);
+      env->heat = NULL;
+    } else {
+      env->heat = compute_heat(env->g);
+    }
   } else if (e->type == SDL_MOUSEBUTTONDOWN) {
     SDL_Point mouse;
     SDL_GetMouseState(&mouse.x, &mouse.y);
@@ -317,11 +405,20 @@ bool process(SDL_Window *win, SDL_Renderer *ren, Env *env, SDL_Event *e) {
             break;
         }
       } else if (isInsideButton(mouse, env->nb_solutions)) {
-        updateButtonText(env, &env->nb_solutions, "Calculating...", win, ren);
-        SDL_RenderPresent(ren);
-        int solutions = game_nb_solutions(env->g);
-        char solutionText[4];
-        snprintf(solutionText, sizeof(solutionText), "%d", solutions);
+        // an estimate first, the exact count on the next click
+        char solutionText[32];
+        if (!env->estimated) {
+          solution_estimate est;
+          game_nb_solutions_estimate(env->g, ESTIMATE_BUDGET, &est);
+          format_estimate(&est, solutionText, sizeof(solutionText));
+        } else {
+          updateButtonText(env, &env->nb_solutions, "Calculating...", win,
+                           ren);
+          SDL_RenderPresent(ren);
+          uint64_t solutions = game_nb_solutions(env->g);
+          snprintf(solutionText, sizeof(solutionText), "%" PRIu64, solutions);
+        }
+        env->estimated = !env->estimated;
         updateButtonText(env, &env->nb_solutions, solutionText, win, ren);
         SDL_RenderPresent(ren);
       } else if (isInsideButton(mouse, env->solve)) {
@@ -333,6 +430,14 @@ bool process(SDL_Window *win, SDL_Renderer *ren, Env *env, SDL_Event *e) {
           updateButtonText(env, &env->solve, "Solve", win, ren);
         }
         SDL_RenderPresent(ren);
+      } else if (isInsideButton(mouse, env->hint)) {
+        deduction d;
+        if (hint_next(env->hints, env->g, &d)) {
+          game_play_move(env->g, d.i, d.j, d.c);
+          updateButtonText(env, &env->hint, "Hint", win, ren);
+        } else {
+          updateButtonText(env, &env->hint, "None", win, ren);
+        }
       } else if (isInsideButton(mouse, env->redo)) {
         game_redo(env->g);
       } else if (isInsideButton(mouse, env->restart)) {
@@ -340,6 +445,7 @@ bool process(SDL_Window *win, SDL_Renderer *ren, Env *env, SDL_Event *e) {
       } else if (isInsideButton(mouse, env->undo)) {
         game_undo(env->g);
       }
+      update_dead_end(env);
     }
   }
   return false;
@@ -350,10 +456,14 @@ bool process(SDL_Window *win, SDL_Renderer *ren, Env *env, SDL_Event *e) {
 void clean(SDL_Window *win, SDL_Renderer *ren, Env *env) {
   free(env->nb_solutions.name);
   free(env->solve.name);
+  free(env->hint.name);
   free(env->undo.name);
   free(env->redo.name);
   free(env->restart.name);
   SDL_DestroyTexture(env->background);
+  hint_delete(env->hints);
+  free(env->dead_end);
+  free(env->heat);
   free(env);
 }
 
@@ -21,9 +21,13 @@ struct Button_t {
 struct Env_t {
   SDL_Texture *background;
   game g;
+  hint_state hints;
+  bool *dead_end; /* true for the clues of a dead end, if any */
+  double *heat;   /* probability of each square to be black, if shown */
+  bool estimated; /* true if the nb solutions button shows an estimate */
   uint square_size;
   uint startX, startY;
-  struct Button_t nb_solutions, solve, undo, redo, restart;
+  struct Button_t nb_solutions, solve, hint, undo, redo, restart;
 };
 
 typedef struct Env_t Env;
@@ -58,6 +62,8 @@ typedef struct Env_t Env;
 #define SCREEN_WIDTH 600
 #define SCREEN_HEIGHT 600
 #define DELAY 100
+#define DEADEND_BUDGET 500 /* search nodes of the dead-end detection */
+#define ESTIMATE_BUDGET 0.2 /* seconds of the solution count estimate */
 
 /* **************************************************************** */
 
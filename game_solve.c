@@ -29,14 +29,86 @@ int main(int argc, char *argv[]) {
       game_solve(g);              // Appel à la fonction de résolution
       game_save(g, output_file);  // Sauvegarde de la solution
     } else if (strcmp("-c", argv[1]) == 0) {
-      int nb = game_nb_solutions(g);  // Appel à la fonction de comptage
+      bigint *nb = game_nb_solutions_ext(g, NULL);  // Appel au comptage
+      char *str = bigint_to_string(nb);
       FILE *f = fopen(output_file, "w");
       if (f == NULL) {
-        fprintf(stderr, "Error opening file for writting: %s\n", output_file);
+        fprintf(stderr, "Error opening file for writing: %s\n", output_file);
         exit(EXIT_FAILURE);
       }
-      fprintf(f, "%d\n", nb);  // Enregistrement du résultat
+      fprintf(f, "%s\n", str);  // Enregistrement du résultat
       fclose(f);
+      free(str);
+      bigint_free(nb);
+    } else if (strcmp("-d", argv[1]) == 0 || strcmp("-p", argv[1]) == 0) {
+      FILE *f = output_file ? fopen(output_file, "w") : stdout;
+      if (f == NULL) {
+        fprintf(stderr, "Error opening file for writing: %s\n", output_file);
+        exit(EXIT_FAILURE);
+      }
+      if (strcmp("-d", argv[1]) == 0)
+        game_export_cnf(g, f);  // Export pour un solveur SAT
+      else
+        game_export_opb(g, f);  // Export pour un solveur pseudo-booléen
+      if (f != stdout) fclose(f);
+    } else if (strcmp("-g", argv[1]) == 0) {
+      const char *grades[] = {"trivial", "easy", "medium", "hard", "unsolved"};
+      FILE *f = output_file ? fopen(output_file, "w") : stdout;
+      if (f == NULL) {
+        fprintf(stderr, "Error opening file for writing: %s\n", output_file);
+        exit(EXIT_FAILURE);
+      }
+      fprintf(f, "%s\n", grades[game_grade(g)]);  // Difficulté logique
+      if (f != stdout) fclose(f);
+    } else if (strcmp("-b", argv[1]) == 0) {
+      uint nb_rows = game_nb_rows(g), nb_cols = game_nb_cols(g);
+      color *fixed = malloc(nb_rows * nb_cols * sizeof(color));
+      if (fixed == NULL) {
+        fprintf(stderr, "Error allocating the backbone\n");
+        game_delete(g);
+        return EXIT_FAILURE;
+      }
+      bool found = game_backbone(g, fixed);  // Cases fixées dans les solutions
+      FILE *f = output_file ? fopen(output_file, "w") : stdout;
+      if (f == NULL) {
+        fprintf(stderr, "Error opening file for writing: %s\n", output_file);
+        exit(EXIT_FAILURE);
+      }
+      for (uint i = 0; i < nb_rows && found; i++) {
+        for (uint j = 0; j < nb_cols; j++) {
+          color c = fixed[i * nb_cols + j];
+          fputc(c == BLACK ? 'b' : c == WHITE ? 'w' : '.', f);
+        }
+        fputc('\n', f);
+      }
+      if (f != stdout) fclose(f);
+      free(fixed);
+    } else if (strcmp("-e", argv[1]) == 0) {
+      solution_estimate est;
+      game_nb_solutions_estimate(g, 1.0, &est);  // Estimation en une seconde
+      FILE *f = output_file ? fopen(output_file, "w") : stdout;
+      if (f == NULL) {
+        fprintf(stderr, "Error opening file for writing: %s\n", output_file);
+        exit(EXIT_FAILURE);
+      }
+      // log10 de l'estimation et de son intervalle de confiance à 95%
+      fprintf(f, "%.3f %.3f %.3f\n", est.log10_estimate, est.log10_low,
+              est.log10_high);
+      if (f != stdout) fclose(f);
+    } else if (strcmp("-m", argv[1]) == 0 && argc == 5) {
+      FILE *f = fopen(argv[3], "r");
+      if (f == NULL) {
+        fprintf(stderr, "Error opening file for reading: %s\n", argv[3]);
+        exit(EXIT_FAILURE);
+      }
+      bool ok = game_import_model(g, f);  // Lecture du modèle du solveur
+      fclose(f);
+      if (!ok) {
+        fprintf(stderr, "No model in file: %s\n", argv[3]);
+        game_delete(g);
+        return EXIT_FAILURE;
+      }
+      game_save(g, argv[4]);
     } else {
       fprintf(stderr, "Unrecognized option: %d\n", option);
       game_delete(g);
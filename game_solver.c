@@ -0,0 +1,935 @@
+/**
+ * @file game_solver.c
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include "game_solver.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_ext.h"
+#include "game_private.h"
+
+/* ************************************************************************** */
+/*                                  AUXILIARY                                 */
+/* ************************************************************************** */
+
+static bool _violated(const solver* s, uint k) {
+  return s->cons_black[k] > s->cons_need[k] ||
+         s->cons_black[k] + s->cons_empty[k] < s->cons_need[k];
+}
+
+/* ************************************************************************** */
+
+static void _enqueue(solver* s, uint k) {
+  if (s->use_tables && !s->tqueued[k]) {
+    s->tqueued[k] = true;
+    s->tqueue[s->tqueue_size++] = k;
+  }
+  if (s->use_linear && !s->lqueued[k]) {
+    s->lqueued[k] = true;
+    s->lqueue[s->lqueue_size++] = k;
+  }
+  if (s->use_probing && !s->probing && !s->pqueued[k]) {
+    s->pqueued[k] = true;
+    s->pqueue[s->pqueue_size++] = k;
+  }
+  if (s->queued[k]) return;
+  s->queued[k] = true;
+  s->queue[s->queue_size++] = k;
+}
+
+/* ************************************************************************** */
+
+static void _clear_queue(solver* s) {
+  while (s->queue_size > 0) s->queued[s->queue[--s->queue_size]] = false;
+  while (s->tqueue_size > 0) s->tqueued[s->tqueue[--s->tqueue_size]] = false;
+  while (s->lqueue_size > 0) s->lqueued[s->lqueue[--s->lqueue_size]] = false;
+  if (s->probing) return;  // the cells left to probe outlive the probes
+  while (s->pqueue_size > 0) s->pqueued[s->pqueue[--s->pqueue_size]] = false;
+  while (s->pcells_size > 0) s->pcelled[s->pcells[--s->pcells_size]] = false;
+}
+
+/* ************************************************************************** */
+
+/* Inserts constraint k at the head of the bucket of its number of empty cells.
+ */
+static void _link(solver* s, uint k) {
+  int b = s->cons_empty[k];
+  s->cons_prev[k] = -1;
+  s->cons_next[k] = s->bucket[b];
+  if (s->bucket[b] >= 0) s->cons_prev[s->bucket[b]] = k;
+  s->bucket[b] = k;
+}
+
+/* ************************************************************************** */
+
+static void _unlink(solver* s, uint k) {
+  if (s->cons_prev[k] >= 0)
+    s->cons_next[s->cons_prev[k]] = s->cons_next[k];
+  else
+    s->bucket[s->cons_empty[k]] = s->cons_next[k];
+  if (s->cons_next[k] >= 0) s->cons_prev[s->cons_next[k]] = s->cons_prev[k];
+}
+
+/* ************************************************************************** */
+
+/* Completes a solver whose constraints are built: reverse index, buckets,
+ * trail and queues. */
+static void _index(solver* s) {
+  uint k, size = s->cons_start[s->nb_cons];
+
+  // build the reverse index, from cells to constraints
+  s->cell_start = (uint*)calloc(s->nb_cells + 1, sizeof(uint));
+  s->cell_cons = (uint*)malloc((size + 1) * sizeof(uint));
+  s->cell_weights = (uint*)malloc((size + 1) * sizeof(uint));
+  assert(s->cell_start && s->cell_cons && s->cell_weights);
+  for (uint p = 0; p < size; p++) s->cell_start[s->cons_cells[p] + 1]++;
+  for (uint x = 0; x < s->nb_cells; x++)
+    s->cell_start[x + 1] += s->cell_start[x];
+  uint* fill = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(fill);
+  for (uint x = 0; x < s->nb_cells; x++) fill[x] = s->cell_start[x];
+  for (k = 0; k < s->nb_cons; k++)
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      s->cell_cons[fill[x]] = k;
+      s->cell_weights[fill[x]++] = s->cons_weights[p];
+    }
+  free(fill);
+
+  // buckets of constraints, by number of empty cells
+  s->cons_prev = (int*)malloc((s->nb_cons + 1) * sizeof(int));
+  s->cons_next = (int*)malloc((s->nb_cons + 1) * sizeof(int));
+  assert(s->cons_prev && s->cons_next);
+  for (uint b = 0; b < SOLVER_NB_BUCKETS; b++) s->bucket[b] = -1;
+  for (k = s->nb_cons; k > 0; k--) _link(s, k - 1);
+
+  // cells outside of any neighbourhood
+  s->free_cells = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(s->free_cells);
+  for (uint x = 0; x < s->nb_cells; x++)
+    if (solver_is_free(s, x)) {
+      s->free_cells[s->nb_free++] = x;
+      if (s->colors[x] == EMPTY) s->nb_free_empty++;
+    }
+
+  s->trail = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  s->queue = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  s->queued = (bool*)calloc(s->nb_cons + 1, sizeof(bool));
+  assert(s->trail && s->queue && s->queued);
+  s->dec_cells = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  s->dec_marks = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  s->dec_colors = (color*)malloc((s->nb_cells + 1) * sizeof(color));
+  s->dec_free = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(s->dec_cells && s->dec_marks && s->dec_colors && s->dec_free);
+
+  tables_init(s);
+  s->tqueue = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  s->tqueued = (bool*)calloc(s->nb_cons + 1, sizeof(bool));
+  assert(s->tqueue && s->tqueued);
+  s->lqueue = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  s->lqueued = (bool*)calloc(s->nb_cons + 1, sizeof(bool));
+  assert(s->lqueue && s->lqueued);
+  s->pqueue = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  s->pqueued = (bool*)calloc(s->nb_cons + 1, sizeof(bool));
+  s->pcells = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  s->pcelled = (bool*)calloc(s->nb_cells + 1, sizeof(bool));
+  assert(s->pqueue && s->pqueued && s->pcells && s->pcelled);
+}
+
+/* ************************************************************************** */
+
+/* Initial propagation of all the constraints. */
+static void _start(solver* s) {
+  for (uint k = 0; k < s->nb_cons; k++) _enqueue(s, k);
+  s->conflict = !solver_propagate(s);
+  _clear_queue(s);
+}
+
+/* ************************************************************************** */
+/*                             SOLVER ROUTINES                                */
+/* ************************************************************************** */
+
+solver* solver_build(cgame g, bool keep_colors, propagation_level level,
+                     const bool* clues) {
+  assert(g);
+  solver* s = (solver*)calloc(1, sizeof(solver));
+  assert(s);
+  s->use_tables = (level != PROPAGATION_COUNT);
+  s->use_linear = (level == PROPAGATION_LINEAR || level == PROPAGATION_PROBE);
+  s->use_probing = (level == PROPAGATION_PROBE);
+  s->nb_rows = game_nb_rows(g);
+  s->nb_cols = game_nb_cols(g);
+  s->nb_cells = s->nb_rows * s->nb_cols;
+  s->wrapping = game_is_wrapping(g);
+  s->colors = (color*)malloc((s->nb_cells + 1) * sizeof(color));
+  assert(s->colors);
+  for (uint i = 0; i < s->nb_rows; i++)
+    for (uint j = 0; j < s->nb_cols; j++)
+      s->colors[i * s->nb_cols + j] =
+          keep_colors ? game_get_color(g, i, j) : EMPTY;
+
+  // count constraints
+  for (uint i = 0; i < s->nb_rows; i++)
+    for (uint j = 0; j < s->nb_cols; j++)
+      if (game_get_constraint(g, i, j) != UNCONSTRAINED &&
+          (!clues || clues[i * s->nb_cols + j]))
+        s->nb_cons++;
+
+  neighbourhood neigh = game_get_neighbourhood(g);
+  direction* dir_array = DIR_ARRAYS[neigh];
+  uint dir_size = DIR_SIZES[neigh];
+  uint max_size = s->nb_cons * dir_size;
+
+  s->cons_square = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  s->cons_need = (int*)malloc((s->nb_cons + 1) * sizeof(int));
+  s->cons_start = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  s->cons_cells = (uint*)malloc((max_size + 1) * sizeof(uint));
+  s->cons_weights = (uint*)malloc((max_size + 1) * sizeof(uint));
+  s->cons_black = (int*)calloc(s->nb_cons + 1, sizeof(int));
+  s->cons_empty = (int*)calloc(s->nb_cons + 1, sizeof(int));
+  assert(s->cons_square && s->cons_need && s->cons_start && s->cons_cells);
+  assert(s->cons_weights && s->cons_black && s->cons_empty);
+
+  // build the neighbourhood of each constraint
+  uint k = 0, size = 0;
+  for (uint i = 0; i < s->nb_rows; i++)
+    for (uint j = 0; j < s->nb_cols; j++) {
+      constraint n = game_get_constraint(g, i, j);
+      if (n == UNCONSTRAINED || (clues && !clues[i * s->nb_cols + j]))
+        continue;
+      s->cons_square[k] = i * s->nb_cols + j;
+      s->cons_need[k] = n;
+      s->cons_start[k] = size;
+      for (uint d = 0; d < dir_size; d++) {
+        uint ii, jj;
+        if (!game_get_next_square(g, i, j, dir_array[d], &ii, &jj)) continue;
+        uint x = ii * s->nb_cols + jj;
+        uint p = s->cons_start[k];
+        while (p < size && s->cons_cells[p] != x) p++;
+        if (p == size) {
+          s->cons_cells[size] = x;
+          s->cons_weights[size++] = 0;
+        }
+        s->cons_weights[p]++;
+        if (s->colors[x] == BLACK) s->cons_black[k]++;
+        if (s->colors[x] == EMPTY) s->cons_empty[k]++;
+      }
+      k++;
+    }
+  s->cons_start[s->nb_cons] = size;
+
+  _index(s);
+  for (k = 0; k < s->nb_cons; k++)
+    if (_violated(s, k)) s->conflict = true;
+  return s;
+}
+
+/* ************************************************************************** */
+
+solver* solver_new(cgame g, bool keep_colors, propagation_level level) {
+  solver* s = solver_build(g, keep_colors, level, NULL);
+  _start(s);
+  return s;
+}
+
+/* ************************************************************************** */
+
+void solver_delete(solver* s) {
+  if (!s) return;
+  free(s->colors);
+  free(s->cons_square);
+  free(s->cons_need);
+  free(s->cons_start);
+  free(s->cons_cells);
+  free(s->cons_weights);
+  free(s->cons_black);
+  free(s->cons_empty);
+  free(s->cell_start);
+  free(s->cell_cons);
+  free(s->cell_weights);
+  free(s->cons_prev);
+  free(s->cons_next);
+  free(s->free_cells);
+  free(s->trail);
+  free(s->queue);
+  free(s->queued);
+  free(s->dec_cells);
+  free(s->dec_marks);
+  free(s->dec_colors);
+  free(s->dec_free);
+  free(s->cons_patterns);
+  free(s->pair_start);
+  free(s->pair_cons);
+  free(s->pair_pos);
+  free(s->tqueue);
+  free(s->tqueued);
+  free(s->lqueue);
+  free(s->lqueued);
+  free(s->pqueue);
+  free(s->pqueued);
+  free(s->pcells);
+  free(s->pcelled);
+  free(s);
+}
+
+/* ************************************************************************** */
+
+uint solver_mark(const solver* s) { return s->trail_size; }
+
+/* ************************************************************************** */
+
+bool solver_assign(solver* s, uint x, color c) {
+  assert(x < s->nb_cells);
+  assert(s->colors[x] == EMPTY);
+  assert(c == WHITE || c == BLACK);
+  bool ok = true;
+  s->colors[x] = c;
+  s->trail[s->trail_size++] = x;
+  if (solver_is_free(s, x)) s->nb_free_empty--;
+  for (uint p = s->cell_start[x]; p < s->cell_start[x + 1]; p++) {
+    uint k = s->cell_cons[p];
+    int w = s->cell_weights[p];
+    _unlink(s, k);
+    s->cons_empty[k] -= w;
+    _link(s, k);
+    if (c == BLACK) s->cons_black[k] += w;
+    if (_violated(s, k)) ok = false;
+    _enqueue(s, k);
+  }
+  return ok;
+}
+
+/* ************************************************************************** */
+
+/* Empties cell x and updates the counters, but not the trail. */
+static void _empty(solver* s, uint x) {
+  color c = s->colors[x];
+  for (uint p = s->cell_start[x]; p < s->cell_start[x + 1]; p++) {
+    uint k = s->cell_cons[p];
+    int w = s->cell_weights[p];
+    _unlink(s, k);
+    s->cons_empty[k] += w;
+    _link(s, k);
+    if (c == BLACK) s->cons_black[k] -= w;
+  }
+  s->colors[x] = EMPTY;
+  if (solver_is_free(s, x)) s->nb_free_empty++;
+}
+
+/* ************************************************************************** */
+
+void solver_undo(solver* s, uint mark) {
+  _clear_queue(s);
+  while (s->trail_size > mark) _empty(s, s->trail[--s->trail_size]);
+}
+
+/* ************************************************************************** */
+
+void solver_unassign(solver* s, uint x) {
+  assert(x < s->nb_cells);
+  assert(s->colors[x] != EMPTY);
+  uint t = s->trail_size;
+  while (s->trail[--t] != x) continue;
+  memmove(&s->trail[t], &s->trail[t + 1],
+          (s->trail_size - t - 1) * sizeof(uint));
+  s->trail_size--;
+  _empty(s, x);
+  for (uint p = s->cell_start[x]; p < s->cell_start[x + 1]; p++)
+    _enqueue(s, s->cell_cons[p]);
+}
+
+/* ************************************************************************** */
+
+/* Propagates the counters of the queued constraints. */
+static bool _propagate_counters(solver* s) {
+  while (s->queue_size > 0) {
+    uint k = s->queue[--s->queue_size];
+    s->queued[k] = false;
+    if (_violated(s, k)) return false;
+    if (s->cons_empty[k] == 0) continue;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] != EMPTY) continue;
+      int w = s->cons_weights[p];
+      int need = s->cons_need[k];
+      if (s->cons_black[k] + w > need) {  // saturated: force white
+        if (!solver_assign(s, x, WHITE)) return false;
+      } else if (s->cons_black[k] + s->cons_empty[k] - w < need) {  // tight
+        if (!solver_assign(s, x, BLACK)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+bool solver_propagate(solver* s) {
+  uint rounds = 0;
+  while (true) {
+    if (!_propagate_counters(s)) return false;
+    if (s->tqueue_size > 0) {
+      if (!tables_propagate(s)) return false;
+      continue;
+    }
+    if (s->lqueue_size > 0) {
+      if (!linear_propagate(s)) return false;
+      continue;
+    }
+    if (!s->use_probing || s->probing) return true;
+    if (rounds++ == PROBE_MAX_ROUNDS) return true;
+    if (!solver_probe(s)) return false;
+    if (s->queue_size == 0) return true;  // nothing fixed by the probing
+  }
+}
+
+/* ************************************************************************** */
+
+bool solver_probe(solver* s) {
+  // the empty cells of the touched constraints join the cells left to probe
+  while (s->pqueue_size > 0) {
+    uint k = s->pqueue[--s->pqueue_size];
+    s->pqueued[k] = false;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] != EMPTY || s->pcelled[x]) continue;
+      s->pcelled[x] = true;
+      s->pcells[s->pcells_size++] = x;
+    }
+  }
+
+  // the cells near the last changes are popped first
+  s->probing = true;
+  while (s->pcells_size > 0) {
+    uint x = s->pcells[--s->pcells_size];
+    s->pcelled[x] = false;
+    if (s->colors[x] != EMPTY) continue;
+    for (color c = WHITE; c <= BLACK; c++) {
+      uint mark = solver_mark(s);
+      s->nb_probes++;
+      bool ok = solver_assign(s, x, c) && solver_propagate(s);
+      solver_undo(s, mark);
+      if (!ok) {
+        // the other color is forced
+        s->probing = false;
+        return solver_assign(s, x, c == WHITE ? BLACK : WHITE);
+      }
+    }
+  }
+  s->probing = false;
+  return true;
+}
+
+/* ************************************************************************** */
+
+uint solver_next_empty(const solver* s, uint x) {
+  while (x < s->nb_cells && s->colors[x] != EMPTY) x++;
+  return x;
+}
+
+/* ************************************************************************** */
+
+bool solver_is_free(const solver* s, uint x) {
+  return s->cell_start[x] == s->cell_start[x + 1];
+}
+
+/* ************************************************************************** */
+
+/* Draws a pseudo-random number (xorshift), from a nonzero state. */
+static uint64_t _random(solver* s) {
+  s->rng ^= s->rng << 13;
+  s->rng ^= s->rng >> 7;
+  s->rng ^= s->rng << 17;
+  return s->rng;
+}
+
+/* ************************************************************************** */
+
+uint solver_choose(solver* s) {
+  // tightest constraint with empty cells
+  for (uint b = 1; b < SOLVER_NB_BUCKETS; b++) {
+    if (s->bucket[b] < 0) continue;
+    uint k = s->bucket[b], best = s->nb_cells, best_degree = 0, nb_ties = 0;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      uint degree = s->cell_start[x + 1] - s->cell_start[x];
+      if (s->colors[x] != EMPTY || degree < best_degree) continue;
+      if (degree > best_degree) {
+        best = x;
+        best_degree = degree;
+        nb_ties = 1;
+      } else if (s->rng && _random(s) % ++nb_ties == 0) {
+        best = x;  // reservoir sampling among the ties
+      }
+    }
+    return best;
+  }
+
+  // only unconstrained cells remain
+  while (s->free_pos < s->nb_free &&
+         s->colors[s->free_cells[s->free_pos]] != EMPTY)
+    s->free_pos++;
+  return s->free_pos < s->nb_free ? s->free_cells[s->free_pos] : s->nb_cells;
+}
+
+/* ************************************************************************** */
+
+void solver_export(const solver* s, game g) {
+  for (uint i = 0; i < s->nb_rows; i++)
+    for (uint j = 0; j < s->nb_cols; j++)
+      game_set_color(g, i, j, s->colors[i * s->nb_cols + j]);
+}
+
+/* ************************************************************************** */
+
+solver* solver_copy(const solver* s) {
+  solver* t = (solver*)malloc(sizeof(solver));
+  assert(t);
+  *t = *s;
+  uint size = s->cons_start[s->nb_cons];
+#define DUP(field, n)                                    \
+  do {                                                   \
+    t->field = malloc(((n) + 1) * sizeof(*s->field));    \
+    assert(t->field);                                    \
+    memcpy(t->field, s->field, ((n) + 1) * sizeof(*s->field)); \
+  } while (0)
+  DUP(colors, s->nb_cells);
+  DUP(cons_square, s->nb_cons);
+  DUP(cons_need, s->nb_cons);
+  DUP(cons_start, s->nb_cons);
+  DUP(cons_cells, size);
+  DUP(cons_weights, size);
+  DUP(cons_black, s->nb_cons);
+  DUP(cons_empty, s->nb_cons);
+  DUP(cell_start, s->nb_cells);
+  DUP(cell_cons, size);
+  DUP(cell_weights, size);
+  DUP(cons_prev, s->nb_cons);
+  DUP(cons_next, s->nb_cons);
+  DUP(free_cells, s->nb_cells);
+  DUP(trail, s->nb_cells);
+  DUP(queue, s->nb_cons);
+  DUP(queued, s->nb_cons);
+  DUP(dec_cells, s->nb_cells);
+  DUP(dec_marks, s->nb_cells);
+  DUP(dec_colors, s->nb_cells);
+  DUP(dec_free, s->nb_cells);
+  DUP(cons_patterns, s->nb_cons * PATTERN_WORDS);
+  DUP(pair_start, s->nb_cons);
+  DUP(pair_cons, s->nb_pairs);
+  DUP(pair_pos, s->nb_pairs * PAIR_BYTES);
+  DUP(tqueue, s->nb_cons);
+  DUP(tqueued, s->nb_cons);
+  DUP(lqueue, s->nb_cons);
+  DUP(lqueued, s->nb_cons);
+  DUP(pqueue, s->nb_cons);
+  DUP(pqueued, s->nb_cons);
+  DUP(pcells, s->nb_cells);
+  DUP(pcelled, s->nb_cells);
+#undef DUP
+  return t;
+}
+
+/* ************************************************************************** */
+/*                             SEARCH ENGINE                                  */
+/* ************************************************************************** */
+
+#define RESTART_BASE 100  // branches before the first restart
+#define RESTART_SEED 0x9E3779B97F4A7C15ULL
+
+static bool _stopped(const solver* s) {
+  return (s->max_nodes > 0 && s->nb_nodes >= s->max_nodes) ||
+         (s->restart_at > 0 && s->nb_nodes >= s->restart_at) ||
+         (s->stop && __atomic_load_n(s->stop, __ATOMIC_RELAXED));
+}
+
+/* ************************************************************************** */
+
+uint64_t solver_luby(uint64_t i) {
+  uint64_t size = 1, seq = 0;
+  while (size < i + 1) {
+    seq++;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != i) {
+    size = (size - 1) / 2;
+    seq--;
+    i = i % size;
+  }
+  return (uint64_t)1 << seq;
+}
+
+/* ************************************************************************** */
+
+/* Depth-first search from the current assignment, without recursion. Each
+ * decision records the trail size before it, so that backtracking is a single
+ * solver_undo(). In first mode, the search stops at the first solution and
+ * keeps it, otherwise the solutions are counted (saturated at UINT64_MAX). */
+static uint64_t _search(solver* s, bool first) {
+  uint64_t cmpt = 0;
+  uint depth = 0;
+  bool ok = true;  // false when the last assignment failed
+  while (true) {
+    if (ok) {
+      if (_stopped(s)) break;
+      uint pos = s->free_pos;
+      uint x = solver_choose(s);
+      if (x == s->nb_cells || solver_is_free(s, x)) {
+        // only free cells remain, each one doubles the count
+        if (first) {
+          for (uint p = s->free_pos; p < s->nb_free; p++)
+            if (s->colors[s->free_cells[p]] == EMPTY)
+              solver_assign(s, s->free_cells[p], WHITE);
+          return 1;  // keep the assignment
+        }
+        uint64_t nb = (s->nb_free_empty < 64) ? (uint64_t)1 << s->nb_free_empty
+                                              : UINT64_MAX;
+        cmpt = (nb > UINT64_MAX - cmpt) ? UINT64_MAX : cmpt + nb;
+        ok = false;
+        continue;
+      }
+      color c = (s->rng && (_random(s) & 1)) ? BLACK : WHITE;
+      s->nb_nodes++;
+      s->dec_cells[depth] = x;
+      s->dec_marks[depth] = solver_mark(s);
+      s->dec_colors[depth] = c;
+      s->dec_free[depth++] = pos;
+      ok = solver_assign(s, x, c) && solver_propagate(s);
+      continue;
+    }
+
+    // backtrack to the last decision with an untried color
+    if (depth == 0) return cmpt;
+    uint d = depth - 1;
+    solver_undo(s, s->dec_marks[d]);
+    s->free_pos = s->dec_free[d];
+    if (s->dec_colors[d] != EMPTY) {
+      color c = (s->dec_colors[d] == WHITE) ? BLACK : WHITE;
+      s->nb_nodes++;
+      s->dec_colors[d] = EMPTY;  // both colors tried
+      ok = solver_assign(s, s->dec_cells[d], c) && solver_propagate(s);
+    } else {
+      depth--;
+    }
+  }
+
+  // stopped: restore the initial state
+  if (depth > 0) solver_undo(s, s->dec_marks[0]);
+  s->free_pos = depth > 0 ? s->dec_free[0] : s->free_pos;
+  return 0;
+}
+
+/* ************************************************************************** */
+
+bool solver_solve(solver* s) {
+  if (s->conflict) return false;
+  uint64_t rng = s->rng;
+  bool found = false;
+  for (uint64_t r = 0; !found; r++) {
+    s->restart_at = s->nb_nodes + RESTART_BASE * solver_luby(r);
+    found = _search(s, true) > 0;
+    if (s->nb_nodes < s->restart_at) break;  // exhausted or stopped
+    if (s->max_nodes > 0 && s->nb_nodes >= s->max_nodes) break;
+    if (s->stop && __atomic_load_n(s->stop, __ATOMIC_RELAXED)) break;
+    if (!s->rng) s->rng = RESTART_SEED;  // new tie-breaks for the next run
+  }
+  s->restart_at = 0;
+  s->rng = rng;
+  return found;
+}
+
+/* ************************************************************************** */
+
+uint64_t solver_count(solver* s) { return s->conflict ? 0 : _search(s, false); }
+
+/* ************************************************************************** */
+/*                             COMPONENTS                                     */
+/* ************************************************************************** */
+
+static uint _find(uint* parent, uint x) {
+  while (parent[x] != x) x = parent[x] = parent[parent[x]];
+  return x;
+}
+
+/* ************************************************************************** */
+
+uint solver_components(const solver* s, uint* comp) {
+  // union of the empty cells of each constraint
+  uint* parent = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(parent);
+  for (uint x = 0; x < s->nb_cells; x++) parent[x] = x;
+  for (uint k = 0; k < s->nb_cons; k++) {
+    uint root = s->nb_cells;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (s->colors[x] != EMPTY) continue;
+      if (root == s->nb_cells)
+        root = _find(parent, x);
+      else
+        parent[_find(parent, x)] = root;
+    }
+  }
+
+  // number the components in order of their first cell
+  uint nb_comps = 0;
+  for (uint x = 0; x < s->nb_cells; x++) comp[x] = s->nb_cells;
+  for (uint x = 0; x < s->nb_cells; x++) {
+    if (s->colors[x] != EMPTY) continue;
+    uint r = _find(parent, x);
+    if (comp[r] == s->nb_cells) comp[r] = nb_comps++;
+    comp[x] = comp[r];
+  }
+  free(parent);
+  return nb_comps;
+}
+
+/* ************************************************************************** */
+
+solver* solver_extract(const solver* s, const uint* cells, uint nb_cells) {
+  solver* t = (solver*)calloc(1, sizeof(solver));
+  assert(t);
+  t->use_tables = s->use_tables;
+  t->use_linear = s->use_linear;
+  t->use_probing = s->use_probing;
+  t->nb_rows = 1;
+  t->nb_cols = nb_cells;
+  t->nb_cells = nb_cells;
+  t->colors = (color*)malloc((nb_cells + 1) * sizeof(color));
+  assert(t->colors);
+  for (uint i = 0; i < nb_cells; i++) t->colors[i] = EMPTY;
+
+  // new index of the extracted cells
+  uint* index = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  bool* taken = (bool*)calloc(s->nb_cons + 1, sizeof(bool));
+  assert(index && taken);
+  for (uint x = 0; x < s->nb_cells; x++) index[x] = s->nb_cells;
+  for (uint i = 0; i < nb_cells; i++) index[cells[i]] = i;
+
+  // constraints covering the extracted cells
+  uint size = 0;
+  for (uint i = 0; i < nb_cells; i++)
+    for (uint p = s->cell_start[cells[i]]; p < s->cell_start[cells[i] + 1];
+         p++) {
+      uint k = s->cell_cons[p];
+      if (taken[k]) continue;
+      taken[k] = true;
+      t->nb_cons++;
+      size += s->cons_start[k + 1] - s->cons_start[k];
+    }
+
+  t->cons_square = (uint*)malloc((t->nb_cons + 1) * sizeof(uint));
+  t->cons_need = (int*)malloc((t->nb_cons + 1) * sizeof(int));
+  t->cons_start = (uint*)malloc((t->nb_cons + 1) * sizeof(uint));
+  t->cons_cells = (uint*)malloc((size + 1) * sizeof(uint));
+  t->cons_weights = (uint*)malloc((size + 1) * sizeof(uint));
+  t->cons_black = (int*)calloc(t->nb_cons + 1, sizeof(int));
+  t->cons_empty = (int*)calloc(t->nb_cons + 1, sizeof(int));
+  assert(t->cons_square && t->cons_need && t->cons_start && t->cons_cells);
+  assert(t->cons_weights && t->cons_black && t->cons_empty);
+
+  // the cells outside of the extraction are fixed: they only lower the need
+  uint k2 = 0;
+  size = 0;
+  for (uint k = 0; k < s->nb_cons; k++) {
+    if (!taken[k]) continue;
+    t->cons_square[k2] = s->cons_square[k];
+    t->cons_need[k2] = s->cons_need[k];
+    t->cons_start[k2] = size;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      if (index[x] == s->nb_cells) {
+        assert(s->colors[x] != EMPTY);
+        if (s->colors[x] == BLACK) t->cons_need[k2] -= s->cons_weights[p];
+        continue;
+      }
+      t->cons_cells[size] = index[x];
+      t->cons_weights[size++] = s->cons_weights[p];
+      t->cons_empty[k2] += s->cons_weights[p];
+    }
+    k2++;
+  }
+  t->cons_start[t->nb_cons] = size;
+  free(index);
+  free(taken);
+
+  _index(t);
+  _start(t);
+  return t;
+}
+
+/* ************************************************************************** */
+
+solver* solver_restrict(const solver* s, const bool* keep,
+                        const color* colors) {
+  solver* t = (solver*)calloc(1, sizeof(solver));
+  assert(t);
+  t->use_tables = s->use_tables;
+  t->use_linear = s->use_linear;
+  t->use_probing = s->use_probing;
+  t->nb_rows = 1;
+
+  // new index of the cells covered by the kept constraints
+  uint* index = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(index);
+  for (uint x = 0; x < s->nb_cells; x++) index[x] = s->nb_cells;
+  uint size = 0;
+  for (uint k = 0; k < s->nb_cons; k++) {
+    if (!keep[k]) continue;
+    t->nb_cons++;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++, size++)
+      if (index[s->cons_cells[p]] == s->nb_cells)
+        index[s->cons_cells[p]] = t->nb_cells++;
+  }
+  t->nb_cols = t->nb_cells;
+  t->colors = (color*)malloc((t->nb_cells + 1) * sizeof(color));
+  assert(t->colors);
+  for (uint x = 0; x < s->nb_cells; x++)
+    if (index[x] != s->nb_cells) t->colors[index[x]] = colors[x];
+
+  t->cons_square = (uint*)malloc((t->nb_cons + 1) * sizeof(uint));
+  t->cons_need = (int*)malloc((t->nb_cons + 1) * sizeof(int));
+  t->cons_start = (uint*)malloc((t->nb_cons + 1) * sizeof(uint));
+  t->cons_cells = (uint*)malloc((size + 1) * sizeof(uint));
+  t->cons_weights = (uint*)malloc((size + 1) * sizeof(uint));
+  t->cons_black = (int*)calloc(t->nb_cons + 1, sizeof(int));
+  t->cons_empty = (int*)calloc(t->nb_cons + 1, sizeof(int));
+  assert(t->cons_square && t->cons_need && t->cons_start && t->cons_cells);
+  assert(t->cons_weights && t->cons_black && t->cons_empty);
+
+  // same counters as solver_build, without any propagation
+  uint k2 = 0;
+  size = 0;
+  for (uint k = 0; k < s->nb_cons; k++) {
+    if (!keep[k]) continue;
+    t->cons_square[k2] = s->cons_square[k];
+    t->cons_need[k2] = s->cons_need[k];
+    t->cons_start[k2] = size;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = index[s->cons_cells[p]];
+      t->cons_cells[size] = x;
+      t->cons_weights[size++] = s->cons_weights[p];
+      if (t->colors[x] == BLACK) t->cons_black[k2] += s->cons_weights[p];
+      if (t->colors[x] == EMPTY) t->cons_empty[k2] += s->cons_weights[p];
+    }
+    k2++;
+  }
+  t->cons_start[t->nb_cons] = size;
+  free(index);
+
+  _index(t);
+  for (uint k = 0; k < t->nb_cons; k++)
+    if (_violated(t, k)) t->conflict = true;
+  return t;
+}
+
+/* ************************************************************************** */
+
+uint solver_split(const solver* s, uint* start, uint* cells) {
+  uint* comp = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(comp);
+  uint nb_comps = solver_components(s, comp);
+
+  // counting sort of the empty cells by component
+  for (uint c = 0; c <= nb_comps; c++) start[c] = 0;
+  for (uint x = 0; x < s->nb_cells; x++)
+    if (comp[x] < nb_comps) start[comp[x] + 1]++;
+  for (uint c = 0; c < nb_comps; c++) start[c + 1] += start[c];
+  for (uint x = 0; x < s->nb_cells; x++)
+    if (comp[x] < nb_comps) cells[start[comp[x]]++] = x;
+  for (uint c = nb_comps; c > 0; c--) start[c] = start[c - 1];
+  start[0] = 0;
+
+  free(comp);
+  return nb_comps;
+}
+
+/* ************************************************************************** */
+
+bigint* solver_count_components(solver* s, const solver_options* opts) {
+  if (s->conflict) return bigint_new(0);
+  uint* start = (uint*)malloc((s->nb_cells + 2) * sizeof(uint));
+  uint* cells = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(start && cells);
+  uint nb_comps = solver_split(s, start, cells);
+
+  bigint* count = bigint_new(1);
+  uint nb_free = 0;
+  for (uint c = 0; c < nb_comps && !bigint_is_zero(count); c++) {
+    uint x = cells[start[c]];
+    if (solver_is_free(s, x)) {
+      nb_free++;  // a free cell is a component on its own
+      continue;
+    }
+    solver* t = solver_extract(s, cells + start[c], start[c + 1] - start[c]);
+    bigint* nb = t->conflict ? bigint_new(0) : classes_count(t);
+    // the cache engine whatever the number of threads: the parallel search
+    // does not split into components, and is exponentially slower on them
+    if (nb == NULL &&
+        (opts->engine == SOLVER_CACHE || opts->engine == SOLVER_AUTO))
+      nb = cache_count(t, opts->cache_size);
+    if (nb == NULL && opts->nb_threads > 1)
+      nb = parallel_count(t, opts->nb_threads);
+    if (nb == NULL) nb = bigint_new(solver_count(t));
+    bigint_mul(count, nb);
+    bigint_free(nb);
+    s->nb_nodes += t->nb_nodes;
+    s->nb_probes += t->nb_probes;
+    solver_delete(t);
+  }
+  bigint_shl(count, nb_free);
+
+  free(start);
+  free(cells);
+  return count;
+}
+
+/* ************************************************************************** */
+
+bool solver_solve_components(solver* s, const solver_options* opts) {
+  if (s->conflict) return false;
+  uint* start = (uint*)malloc((s->nb_cells + 2) * sizeof(uint));
+  uint* cells = (uint*)malloc((s->nb_cells + 1) * sizeof(uint));
+  assert(start && cells);
+  uint nb_comps = solver_split(s, start, cells);
+
+  uint mark = solver_mark(s);
+  bool found = true;
+  for (uint c = 0; c < nb_comps && found; c++) {
+    uint nb = start[c + 1] - start[c];
+    if (solver_is_free(s, cells[start[c]])) {
+      solver_assign(s, cells[start[c]], WHITE);  // free cell
+      continue;
+    }
+    solver* t = solver_extract(s, cells + start[c], nb);
+    if (opts->engine == SOLVER_CDCL ||
+        (opts->engine == SOLVER_AUTO && opts->nb_threads <= 1))
+      found = cdcl_solve(t);
+    else if (opts->nb_threads > 1)
+      found = parallel_solve(t, opts->nb_threads);
+    else
+      found = solver_solve(t);
+    // copy the solution of the component back, without propagation
+    for (uint i = 0; i < nb && found; i++)
+      solver_assign(s, cells[start[c] + i], t->colors[i]);
+    s->nb_nodes += t->nb_nodes;
+    s->nb_probes += t->nb_probes;
+    s->nb_conflicts += t->nb_conflicts;
+    solver_delete(t);
+  }
+  if (!found) solver_undo(s, mark);
+  _clear_queue(s);
+
+  free(start);
+  free(cells);
+  return found;
+}
+
+/* ************************************************************************** */
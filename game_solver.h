@@ -0,0 +1,576 @@
+/**
+ * @file game_solver.h
+ * @brief Private Solver Engine.
+ * @details The solver works on a flat view of the grid: every constrained
+ * square becomes a cardinality constraint over the cells of its neighbourhood,
+ * and black/empty counters are maintained incrementally for each constraint.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#ifndef __GAME_SOLVER_H__
+#define __GAME_SOLVER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bigint.h"
+#include "game.h"
+#include "game_ext.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/** number of buckets of constraints, indexed by their number of empty cells */
+#define SOLVER_NB_BUCKETS 10
+
+/** number of 64-bit words of a set of patterns (over at most 9 cells) */
+#define PATTERN_WORDS 8
+
+/** bytes per pair of constraints: number of shared cells, then their
+ * positions in both constraints */
+#define PAIR_BYTES 19
+
+/** number of cells forced by the probing within one propagation */
+#define PROBE_MAX_ROUNDS 64
+
+/**
+ * @brief Solver structure.
+ * @details Constraints and cells are stored in compressed (CSR) form: the
+ * cells of constraint k are cons_cells[cons_start[k] .. cons_start[k+1]-1],
+ * and the constraints covering cell x are cell_cons[cell_start[x] ..
+ * cell_start[x+1]-1]. On small wrapping grids, a cell may appear several times
+ * in the same neighbourhood: it is then stored once with a weight.
+ */
+struct solver_s {
+  uint nb_rows;        /**< number of rows in the grid */
+  uint nb_cols;        /**< number of columns in the grid */
+  uint nb_cells;       /**< number of cells in the grid */
+  bool wrapping;       /**< the wrapping option */
+  color* colors;       /**< current color of each cell (row-major) */
+  uint nb_cons;        /**< number of constraints */
+  uint* cons_square;   /**< index of the constrained square */
+  int* cons_need;      /**< expected number of black cells */
+  uint* cons_start;    /**< offsets into cons_cells (nb_cons+1 entries) */
+  uint* cons_cells;    /**< cells of each neighbourhood */
+  uint* cons_weights;  /**< multiplicity of each cell in the neighbourhood */
+  int* cons_black;     /**< current number of black cells (weighted) */
+  int* cons_empty;     /**< current number of empty cells (weighted) */
+  uint* cell_start;    /**< offsets into cell_cons (nb_cells+1 entries) */
+  uint* cell_cons;     /**< constraints covering each cell */
+  uint* cell_weights;  /**< multiplicity of the cell in each constraint */
+  uint* trail;         /**< assigned cells, in assignment order */
+  uint trail_size;     /**< number of cells on the trail */
+  uint* queue;         /**< constraints waiting for propagation */
+  uint queue_size;     /**< number of constraints in the queue */
+  bool* queued;        /**< true if the constraint is in the queue */
+  int* cons_prev;      /**< previous constraint in the same bucket (or -1) */
+  int* cons_next;      /**< next constraint in the same bucket (or -1) */
+  int bucket[SOLVER_NB_BUCKETS]; /**< first constraint with k empty cells */
+  uint* free_cells;    /**< cells not covered by any constraint */
+  uint nb_free;        /**< number of cells not covered by any constraint */
+  uint free_pos;       /**< free cells before this position are assigned */
+  uint nb_free_empty;  /**< number of free cells still empty */
+  uint* dec_cells;     /**< decision stack: decided cell */
+  uint* dec_marks;     /**< decision stack: trail size before the decision */
+  color* dec_colors;   /**< decision stack: color currently tried */
+  uint* dec_free;      /**< decision stack: free_pos before the decision */
+  bool use_tables;     /**< true to propagate with the pattern tables */
+  bool use_linear;     /**< true to propagate with linear equations */
+  bool use_probing;    /**< true to propagate with failed-literal probing */
+  bool probing;        /**< true while a probe is being propagated */
+  uint64_t* cons_patterns; /**< feasible patterns of each constraint */
+  uint nb_pairs;       /**< number of pairs of overlapping constraints */
+  uint* pair_start;    /**< offsets into pair_cons (nb_cons+1 entries) */
+  uint* pair_cons;     /**< constraints overlapping each constraint */
+  uint8_t* pair_pos;   /**< shared cells of each pair (PAIR_BYTES each) */
+  uint* tqueue;        /**< constraints waiting for table propagation */
+  uint tqueue_size;    /**< number of constraints in the table queue */
+  bool* tqueued;       /**< true if the constraint is in the table queue */
+  uint* lqueue;        /**< constraints waiting for linear propagation */
+  uint lqueue_size;    /**< number of constraints in the linear queue */
+  bool* lqueued;       /**< true if the constraint is in the linear queue */
+  uint* pqueue;        /**< constraints touched since their cells were
+                          last probed */
+  uint pqueue_size;    /**< number of constraints in the probing queue */
+  bool* pqueued;       /**< true if the constraint is in the probing queue */
+  uint* pcells;        /**< cells waiting to be probed */
+  uint pcells_size;    /**< number of cells waiting to be probed */
+  bool* pcelled;       /**< true if the cell is waiting to be probed */
+  uint64_t nb_nodes;   /**< number of branches tried by the search */
+  uint64_t nb_probes;  /**< number of colors tried by the probing */
+  uint64_t nb_conflicts; /**< number of conflicts met by the CDCL engine */
+  bool conflict;       /**< true if the initial state is inconsistent */
+  bool* stop;          /**< if not NULL, the search stops when set to true */
+  uint64_t max_nodes;  /**< if not 0, the search stops after this number of
+                          branches */
+  uint64_t restart_at; /**< if not 0, the first-solution search restarts once
+                          nb_nodes reaches it */
+  uint64_t rng;        /**< state of the tie-breaking generator, 0 to break
+                          ties deterministically */
+};
+
+typedef struct solver_s solver;
+
+/* ************************************************************************** */
+/*                             SOLVER ROUTINES                                */
+/* ************************************************************************** */
+
+/**
+ * @brief Creates a solver for a given game.
+ * @param g the game
+ * @param keep_colors if true, the current colors of @p g are kept as initial
+ * assignments, otherwise the solver starts from an empty grid
+ * @param level the propagation level
+ * @return the created solver, already propagated (see @ref solver_propagate)
+ */
+solver* solver_new(cgame g, bool keep_colors, propagation_level level);
+
+/**
+ * @brief Creates a solver for a given game, without any propagation.
+ * @details Same as @ref solver_new, for the engines that record their own
+ * deductions. The conflict flag is only set if a constraint is already
+ * violated by the kept colors.
+ * @param clues if not NULL, only the constrained squares q with clues[q] set
+ * (row-major) become constraints, the other ones are ignored
+ */
+solver* solver_build(cgame g, bool keep_colors, propagation_level level,
+                     const bool* clues);
+
+/** delete a solver */
+void solver_delete(solver* s);
+
+/** get the current trail size, to be given later to @ref solver_undo */
+uint solver_mark(const solver* s);
+
+/**
+ * @brief Assigns a color to an empty cell and updates the counters.
+ * @details The constraints covering the cell are queued for propagation.
+ * @return false if a constraint is violated by this assignment
+ */
+bool solver_assign(solver* s, uint x, color c);
+
+/** unassign all the cells assigned since the trail had size @p mark */
+void solver_undo(solver* s, uint mark);
+
+/**
+ * @brief Unassigns one cell, wherever it is on the trail.
+ * @details The constraints covering the cell are queued for propagation. The
+ * cells assigned after it stay assigned (their propagation is not undone).
+ */
+void solver_unassign(solver* s, uint x);
+
+/**
+ * @brief Propagates the queued constraints.
+ * @details As soon as a constraint is saturated (enough black cells) or tight
+ * (not enough empty cells left), its remaining empty cells are forced. Then,
+ * if use_tables is set, the pattern tables are used (see @ref
+ * tables_propagate), then the linear equations if use_linear is set (see
+ * @ref linear_propagate), until nothing more can be forced. Finally, if
+ * use_probing is set, the empty cells are probed (see @ref solver_probe), for
+ * at most PROBE_MAX_ROUNDS forced cells: the probing of the others is left
+ * to the next propagation.
+ * @return false if a conflict is detected
+ */
+bool solver_propagate(solver* s);
+
+/**
+ * @brief Failed-literal probing.
+ * @details Only the empty constrained cells of the constraints touched since
+ * the last probing are tried, in both colors: the probes of the other cells
+ * already succeeded. If one color leads to a conflict after propagation, the
+ * cell is set to the other one and the function returns, so that this
+ * assignment is propagated before probing again. The cells left to probe are
+ * forgotten on backtracking (see @ref solver_undo).
+ * @return false if both colors of a cell lead to a conflict
+ */
+bool solver_probe(solver* s);
+
+/** get the next empty cell starting from @p x (or nb_cells if none) */
+uint solver_next_empty(const solver* s, uint x);
+
+/** test if a cell is free, i.e. covered by no constraint */
+bool solver_is_free(const solver* s, uint x);
+
+/**
+ * @brief Chooses the next cell to decide (most constrained first).
+ * @details The cell is taken in the constraint with the fewest empty cells,
+ * preferring the cell covered by the most constraints. Cells not covered by
+ * any constraint come last. If the generator of the solver is seeded, the
+ * ties between cells are broken at random.
+ * @return the chosen empty cell, or nb_cells if the grid is complete
+ */
+uint solver_choose(solver* s);
+
+/** copy the current colors of the solver into a game */
+void solver_export(const solver* s, game g);
+
+/** duplicate a solver, with its current assignment */
+solver* solver_copy(const solver* s);
+
+/* ************************************************************************** */
+/*                             SEARCH ENGINE                                  */
+/* ************************************************************************** */
+
+/**
+ * @brief Searches the first solution.
+ * @details The search is iterative, with an explicit stack of decisions over
+ * the trail, so its depth is not limited by the call stack. The next cell is
+ * chosen by @ref solver_choose. The search restarts from scratch after a
+ * number of branches following the Luby sequence (see @ref solver_luby), the
+ * ties of @ref solver_choose being broken at random after the first restart,
+ * so that a bad early decision does not trap it in a huge subtree. It remains
+ * complete, since the budgets grow without bound. On success, the solution is
+ * kept as the current assignment of the solver. Otherwise, the solver is
+ * restored in its initial state.
+ * @return true if a solution is found, false otherwise (or if stopped)
+ */
+bool solver_solve(solver* s);
+
+/** get the i-th term of the Luby sequence: 1, 1, 2, 1, 1, 2, 4, 1, 1, ... */
+uint64_t solver_luby(uint64_t i);
+
+/**
+ * @brief Counts the solutions extending the current assignment.
+ * @details Once only free cells remain (see @ref solver_choose), they are not
+ * searched: each of them doubles the count.
+ * @return the number of solutions (saturated at UINT64_MAX)
+ */
+uint64_t solver_count(solver* s);
+
+/* ************************************************************************** */
+/*                             COMPONENTS                                     */
+/* ************************************************************************** */
+
+/**
+ * @brief Labels the empty cells by connected component.
+ * @details Two empty cells are connected when they belong to the same
+ * constraint. Distinct components never interact, so they can be solved or
+ * counted separately.
+ * @param comp output array of nb_cells entries: component of each empty cell,
+ * or nb_cells for assigned cells
+ * @return the number of components
+ */
+uint solver_components(const solver* s, uint* comp);
+
+/**
+ * @brief Groups the empty cells by connected component.
+ * @param start output array of nb_cells+2 entries: the cells of component c
+ * are cells[start[c] .. start[c+1]-1]
+ * @param cells output array of nb_cells entries
+ * @return the number of components
+ */
+uint solver_split(const solver* s, uint* start, uint* cells);
+
+/**
+ * @brief Creates a solver restricted to some empty cells.
+ * @details The cells must be a union of components (see @ref
+ * solver_components). Cell i of the new solver is cells[i], and the constraints
+ * only keep these cells, the other ones being already assigned.
+ */
+solver* solver_extract(const solver* s, const uint* cells, uint nb_cells);
+
+/**
+ * @brief Creates a solver on some of the constraints of another one.
+ * @details Same as @ref solver_build with a subset of the clues, without
+ * reading the game again: the cells are those covered by the constraints k
+ * with keep[k], renumbered on a single row, and colored as in @p colors (an
+ * array over the cells of @p s). No propagation is done.
+ */
+solver* solver_restrict(const solver* s, const bool* keep,
+                        const color* colors);
+
+/**
+ * @brief Counts the solutions component by component.
+ * @details Each component is extracted and counted on its own, with the class
+ * engine when it applies, or else with the engine and the number of threads
+ * given by @p opts. The counts are multiplied. Free cells are not
+ * extracted: they account for a power of two.
+ * @return the number of solutions
+ */
+bigint* solver_count_components(solver* s, const solver_options* opts);
+
+/**
+ * @brief Searches the first solution component by component.
+ * @details Each component is extracted and solved with the engine and the
+ * number of threads given by @p opts. On success, the solutions of the
+ * components are copied in the solver @p s, and the free cells are set to
+ * white. Otherwise, @p s is left unchanged.
+ * @return true if a solution is found, false otherwise
+ */
+bool solver_solve_components(solver* s, const solver_options* opts);
+
+/* ************************************************************************** */
+/*                             PARALLEL ENGINE                                */
+/* ************************************************************************** */
+
+/**
+ * @brief Searches the first solution with several threads.
+ * @details The search tree is split at shallow depths into tasks, which are
+ * pushed on per-thread work-stealing deques. Each thread works on its own
+ * copy of the solver, and all of them are cancelled as soon as one of them
+ * succeeds. On success, the solution is copied in the solver @p s.
+ * @return true if a solution is found, false otherwise
+ */
+bool parallel_solve(solver* s, uint nb_threads);
+
+/**
+ * @brief Counts the solutions with several threads.
+ * @details Same task splitting as @ref parallel_solve. The counts of the
+ * threads are summed at the end, so the result does not depend on scheduling.
+ * @return the number of solutions
+ */
+bigint* parallel_count(solver* s, uint nb_threads);
+
+/* ************************************************************************** */
+/*                             TABLE ENGINE                                   */
+/* ************************************************************************** */
+
+/**
+ * @brief Builds the pattern tables of the constraints.
+ * @details The feasible patterns of a constraint are the colorings of its
+ * (at most 9) cells with the right number of black cells. They come from a
+ * precomputed table, except for weighted cells on small wrapping grids. The
+ * pairs of constraints sharing cells are listed with their shared cells.
+ */
+void tables_init(solver* s);
+
+/**
+ * @brief Propagates the constraints of the table queue.
+ * @details The patterns of a constraint still compatible with the current
+ * colors are filtered by each overlapping constraint: a pattern is kept only
+ * if its restriction to the shared cells is the restriction of a compatible
+ * pattern of the other constraint. A cell with the same color in all the
+ * remaining patterns is forced. For a single cardinality constraint, this is
+ * the same as the counter rule; the pairs make it stronger.
+ * @return false if a conflict is detected; returns as soon as a constraint
+ * forces cells, so that the counters are propagated first
+ */
+bool tables_propagate(solver* s);
+
+/* ************************************************************************** */
+/*                             LINEAR ENGINE                                  */
+/* ************************************************************************** */
+
+/**
+ * @brief Propagates the constraints of the linear queue.
+ * @details Each constraint is an equation: the sum of its empty cells (0 for
+ * white, 1 for black, with their weights) is its residual need. The equations
+ * of a constraint and of its overlapping constraints are reduced by integer
+ * Gauss-Jordan elimination, eliminating first the cells shared by the most
+ * equations. Then, a cell is forced if only one of its colors keeps each
+ * reduced equation within the bounds of its other cells. A reduced equation
+ * without integer solution, or out of its bounds, is a conflict.
+ * @return false if a conflict is detected; returns as soon as a block forces
+ * cells, so that the counters and the tables are propagated first
+ */
+bool linear_propagate(solver* s);
+
+/* ************************************************************************** */
+/*                             CDCL ENGINE                                    */
+/* ************************************************************************** */
+
+/**
+ * @brief Searches the first solution with conflict-driven clause learning.
+ * @details The constraints are propagated with the counters, and each forced
+ * cell records the constraint that forced it. Its explanation, computed when
+ * needed, is the set of cells of this constraint with the color that forced
+ * it, assigned before it. A conflict is analyzed back to its first unique
+ * implication point, and the learnt clause (a nogood over cell colors) makes
+ * the search backjump non-chronologically. The cells are decided by activity
+ * (the cells involved in recent conflicts first) with their last color, the
+ * search restarts following the Luby sequence, and the learnt clauses with
+ * the most decision levels are regularly deleted. On success, the solution
+ * is kept as the current assignment of the solver (with the free cells set to
+ * white). Otherwise, the solver is restored in its initial state.
+ * @return true if a solution is found, false otherwise
+ */
+bool cdcl_solve(solver* s);
+
+/**
+ * @brief Computes the backbone: the cells with the same color in all the
+ * solutions.
+ * @details A first solution gives the candidates. Each candidate left is then
+ * tried with its other color as an assumption: a solution drops it, with all
+ * the candidates it also flips (their other colors being tried first), and a
+ * refutation fixes it at level 0. The learnt clauses are kept from one call to
+ * the next. The solver is restored in its initial state.
+ * @param fixed set to the color of each backbone cell, and EMPTY for the other
+ * cells (all of them if there is no solution)
+ * @return true if there is a solution, false otherwise
+ */
+bool cdcl_backbone(solver* s, color* fixed);
+
+/* ************************************************************************** */
+/*                             ESTIMATOR ENGINE                               */
+/* ************************************************************************** */
+
+/**
+ * @brief Estimates the number of solutions with random probes.
+ * @details The components are estimated separately, and their estimates
+ * multiplied: a component whose search takes less than a thousand nodes is
+ * counted exactly, and the other ones get one probe per round until the
+ * budget is spent. A probe follows a random branch of the search, choosing
+ * the cells with @ref solver_choose: its estimate is 2 to the number of
+ * decisions where both colors propagate, and of free cells left at its end,
+ * or 0 if it ends in a conflict. The means are kept scaled by the largest
+ * probe, so that they do not overflow, and their relative variances are
+ * summed for the confidence interval of the product.
+ * @param s the solver, already propagated
+ * @param budget time budget in seconds, checked after each round of probes
+ * (0 for none if @p max_probes is set, or else a single round)
+ * @param max_probes number of probes after which the rounds stop, checked
+ * after each round too (0 for none)
+ * @param est the estimate
+ */
+void estimate_count(solver* s, double budget, uint64_t max_probes,
+                    solution_estimate* est);
+
+/* ************************************************************************** */
+/*                             CLASS ENGINE                                   */
+/* ************************************************************************** */
+
+/**
+ * @brief Counts the solutions over classes of interchangeable cells.
+ * @details Empty cells covered by exactly the same constraints (with the same
+ * weights) form a class: only its number b of black cells matters, and there
+ * are C(k, b) ways to place them among its k cells. The search branches on
+ * the number of black cells of each class, and multiplies the binomials.
+ * @param s the solver, already propagated and without conflict
+ * @return the number of solutions, or NULL if the classes are not large enough
+ * for this engine to be worth it
+ */
+bigint* classes_count(solver* s);
+
+/* ************************************************************************** */
+/*                             CACHE ENGINE                                   */
+/* ************************************************************************** */
+
+/**
+ * @brief Counts the solutions with a component-caching search.
+ * @details After each decision and its propagation, the empty cells are split
+ * again into connected components, counted independently. The count of each
+ * component is cached under its canonical key: its sorted cells and the
+ * residual need of its constraints. When the cache exceeds its memory budget,
+ * the entries unused for the longest time are evicted.
+ * @param s the solver, already propagated and without conflict
+ * @param budget memory budget of the cache in bytes (0 for the default one)
+ * @return the number of solutions
+ */
+bigint* cache_count(solver* s, size_t budget);
+
+/**
+ * @brief Counts the solutions, and the solutions with each cell black.
+ * @details Same search as @ref cache_count, where each component also gets
+ * the number of its solutions with each of its cells black, cached with its
+ * count: in a branch, a cell black by propagation counts all the solutions
+ * of the branch, and a cell of a subcomponent its own count times the counts
+ * of the other subcomponents.
+ * @param s the solver, already propagated and without conflict
+ * @param budget memory budget of the cache in bytes (0 for the default one)
+ * @param black array of nb_cells counters, to which the number of solutions
+ * with each cell black is added
+ * @return the number of solutions
+ */
+bigint* cache_marginals(solver* s, size_t budget, bigint** black);
+
+/* ************************************************************************** */
+/*                             DECISION DIAGRAMS                              */
+/* ************************************************************************** */
+
+#define ZDD_FALSE 0 /**< the empty set of solutions */
+#define ZDD_TRUE 1  /**< the single solution with no more black cell */
+
+/**
+ * @brief Node store of a zero-suppressed decision diagram.
+ * @details The variables are the positions of the sweep order. Node k tests
+ * position var[k]: lo[k] is followed if the cell is white, hi[k] if it is
+ * black, and the positions skipped by an edge are white. The children of a
+ * node have smaller indices, and no node is created with hi = ZDD_FALSE or
+ * twice with the same fields.
+ */
+typedef struct {
+  uint nb_vars;    /**< number of positions (the variable of terminals) */
+  uint nb_nodes;   /**< number of nodes, terminals included */
+  uint capacity;   /**< number of allocated nodes */
+  uint* var;       /**< tested position of each node */
+  uint* lo;        /**< child of each node with the cell white */
+  uint* hi;        /**< child of each node with the cell black */
+  uint* table;     /**< unique table of node indices (0 for free slots) */
+  uint table_size; /**< size of the unique table, a power of 2 */
+  uint root;       /**< root of the diagram */
+} zdd;
+
+/**
+ * @brief Initializes a node store with the two terminals.
+ * @param z the store
+ * @param nb_vars the number of variables
+ */
+void zdd_init(zdd* z, uint nb_vars);
+
+/**
+ * @brief Frees the nodes of a store.
+ */
+void zdd_free(zdd* z);
+
+/**
+ * @brief Returns the node (var, lo, hi), created if it does not exist yet.
+ * @details If hi is ZDD_FALSE, the node is lo itself. The variable must be
+ * smaller than the ones of both children.
+ */
+uint zdd_node(zdd* z, uint var, uint lo, uint hi);
+
+/* ************************************************************************** */
+/*                             ROW DP ENGINE                                  */
+/* ************************************************************************** */
+
+/**
+ * @brief Counts the solutions by dynamic programming over a row profile.
+ * @details The grid is swept cell by cell along its narrower side. The state
+ * is the coloring of the cells still needed by an incomplete constraint, and
+ * each state of the hashed table carries its number of partial solutions. The
+ * cells needed for long, such as the first lines of a wrapping grid until the
+ * constraints around the seam are closed, are pinned in fixed bits of the
+ * state instead of the shifting window, so that a single sweep counts all the
+ * solutions.
+ * @param s the solver, already propagated and without conflict
+ * @return the number of solutions, or NULL if the profile of the grid is too
+ * wide for this engine, or if a table goes over a million states (the
+ * component engines are then much faster)
+ */
+bigint* rowdp_count(solver* s);
+
+/**
+ * @brief Counts the solutions, and the solutions with each cell black.
+ * @details Same sweep as @ref rowdp_count, followed by a backward one: the
+ * number of completions of each state, times its number of partial
+ * solutions, gives the solutions through this state, so that the solutions
+ * with a cell black are summed over the states that make it black. The
+ * backward sweep needs the forward tables in reverse order: only one every
+ * sqrt(n) of them is kept, and the ones in between are computed again.
+ * @param s the solver, already propagated and without conflict
+ * @param black array of nb_cells counters, to which the number of solutions
+ * with each cell black is added
+ * @return the number of solutions, or NULL if the profile of the grid is too
+ * wide or has too many states (the counters are then meaningless)
+ */
+bigint* rowdp_marginals(solver* s, bigint** black);
+
+/**
+ * @brief Compiles the solutions into a zero-suppressed decision diagram.
+ * @details Same sweep as @ref rowdp_marginals, but the backward sweep builds
+ * the node of each state instead of its number of completions: its children
+ * are the nodes of the states reached with the cell white and black (the
+ * black constants in between being chained before them). The nodes of equal
+ * states are thus shared, and the unique table shares the equal subdiagrams
+ * of different states.
+ * @param s the solver, already propagated and without conflict
+ * @param z an initialized node store, whose root is set
+ * @param order array of nb_cells cells, set to the cell of each position
+ * @return the number of solutions, or NULL if the profile of the grid is too
+ * wide or has too many states (the store then holds meaningless nodes)
+ */
+bigint* rowdp_compile(solver* s, zdd* z, uint* order);
+
+#endif  // __GAME_SOLVER_H__
@@ -8,6 +8,7 @@
 #define __GAME_STRUCT_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "game.h"
 #include "game_ext.h"
@@ -17,20 +18,21 @@
 /*                             DATA TYPES                                     */
 /* ************************************************************************** */
 
-typedef struct square_s {
-  color c;      /**< square color */
-  constraint n; /**< square constraint */
-} square;
-
 /**
  * @brief Game structure.
- * @details This is an opaque data type.
+ * @details This is an opaque data type. Colors are stored as bitboards: each
+ * row of the grid uses row_words 64-bit words in the black array and in the
+ * white array, bit (j % 64) of word (j / 64) standing for column j. A square is
+ * EMPTY when its bit is set in neither of them.
  */
 struct game_s {
   char offset[100];    /**< offset to prevent direct access to struct fields */
   uint nb_rows;        /**< number of rows in the game */
   uint nb_cols;        /**< number of columns in the game */
-  square* squares;     /**< the grid of squares using row-major storage */
+  signed char* constraints; /**< square constraints (row-major storage) */
+  uint row_words;      /**< number of 64-bit words per row of bitboard */
+  uint64_t* black;     /**< black bitboard */
+  uint64_t* white;     /**< white bitboard */
   bool wrapping;       /**< the wrapping option */
   neighbourhood neigh; /**< the unique option */
   queue* undo_stack;   /**< stack to undo moves */
@@ -42,8 +44,19 @@ struct game_s {
 /* ************************************************************************** */
 
 #define INDEX(g, i, j) ((i) * (g->nb_cols) + (j))
-#define SQUARE(g, i, j) ((g)->squares[(INDEX(g, i, j))])
-#define CONSTRAINT(g, i, j) (SQUARE(g, i, j).n)
-#define COLOR(g, i, j) (SQUARE(g, i, j).c)
+#define CONSTRAINT(g, i, j) ((g)->constraints[(INDEX(g, i, j))])
+#define WORD(g, i, j) ((i) * (g)->row_words + ((j) >> 6))
+#define BIT(j) ((uint64_t)1 << ((j)&63))
+#define IS_BLACK(g, i, j) (((g)->black[WORD(g, i, j)] & BIT(j)) != 0)
+#define IS_WHITE(g, i, j) (((g)->white[WORD(g, i, j)] & BIT(j)) != 0)
+#define COLOR(g, i, j) \
+  (IS_BLACK(g, i, j) ? BLACK : (IS_WHITE(g, i, j) ? WHITE : EMPTY))
+#define SET_COLOR(g, i, j, c)                                   \
+  do {                                                          \
+    uint64_t* _pb = &(g)->black[WORD(g, i, j)];                 \
+    uint64_t* _pw = &(g)->white[WORD(g, i, j)];                 \
+    *_pb = ((c) == BLACK) ? (*_pb | BIT(j)) : (*_pb & ~BIT(j)); \
+    *_pw = ((c) == WHITE) ? (*_pw | BIT(j)) : (*_pw & ~BIT(j)); \
+  } while (0)
 
 #endif  // __GAME_STRUCT_H__
@@ -0,0 +1,241 @@
+/**
+ * @file game_tables.c
+ * @brief Propagation with tables of feasible patterns.
+ * @copyright University of Bordeaux. All rights reserved, 2023.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/* A pattern is a coloring of the cells of a constraint: bit i is set if the
+ * i-th cell of the constraint is black. A set of patterns is a bitset of
+ * PATTERN_WORDS words, since a constraint has at most 9 cells. */
+
+/* POPCOUNT_PATTERNS[n]: the 9-bit patterns with n black cells. */
+static const uint64_t POPCOUNT_PATTERNS[10][PATTERN_WORDS] = {
+    {0x0000000000000001ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+     0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+     0x0000000000000000ULL, 0x0000000000000000ULL},
+    {0x0000000100010116ULL, 0x0000000000000001ULL, 0x0000000000000001ULL,
+     0x0000000000000000ULL, 0x0000000000000001ULL, 0x0000000000000000ULL,
+     0x0000000000000000ULL, 0x0000000000000000ULL},
+    {0x0001011601161668ULL, 0x0000000100010116ULL, 0x0000000100010116ULL,
+     0x0000000000000001ULL, 0x0000000100010116ULL, 0x0000000000000001ULL,
+     0x0000000000000001ULL, 0x0000000000000000ULL},
+    {0x0116166816686880ULL, 0x0001011601161668ULL, 0x0001011601161668ULL,
+     0x0000000100010116ULL, 0x0001011601161668ULL, 0x0000000100010116ULL,
+     0x0000000100010116ULL, 0x0000000000000001ULL},
+    {0x1668688068808000ULL, 0x0116166816686880ULL, 0x0116166816686880ULL,
+     0x0001011601161668ULL, 0x0116166816686880ULL, 0x0001011601161668ULL,
+     0x0001011601161668ULL, 0x0000000100010116ULL},
+    {0x6880800080000000ULL, 0x1668688068808000ULL, 0x1668688068808000ULL,
+     0x0116166816686880ULL, 0x1668688068808000ULL, 0x0116166816686880ULL,
+     0x0116166816686880ULL, 0x0001011601161668ULL},
+    {0x8000000000000000ULL, 0x6880800080000000ULL, 0x6880800080000000ULL,
+     0x1668688068808000ULL, 0x6880800080000000ULL, 0x1668688068808000ULL,
+     0x1668688068808000ULL, 0x0116166816686880ULL},
+    {0x0000000000000000ULL, 0x8000000000000000ULL, 0x8000000000000000ULL,
+     0x6880800080000000ULL, 0x8000000000000000ULL, 0x6880800080000000ULL,
+     0x6880800080000000ULL, 0x1668688068808000ULL},
+    {0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+     0x8000000000000000ULL, 0x0000000000000000ULL, 0x8000000000000000ULL,
+     0x8000000000000000ULL, 0x6880800080000000ULL},
+    {0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+     0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+     0x0000000000000000ULL, 0x8000000000000000ULL},
+};
+
+/* ************************************************************************** */
+/*                                 PATTERNS                                   */
+/* ************************************************************************** */
+
+/* Computes the patterns of constraint k compatible with the current colors. */
+static void _alive(const solver* s, uint k, uint64_t* alive) {
+  const uint64_t* table = s->cons_patterns + k * PATTERN_WORDS;
+  uint black = 0, white = 0;
+  for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+    uint i = p - s->cons_start[k];
+    if (s->colors[s->cons_cells[p]] == BLACK) black |= 1u << i;
+    if (s->colors[s->cons_cells[p]] == WHITE) white |= 1u << i;
+  }
+  for (uint w = 0; w < PATTERN_WORDS; w++) {
+    alive[w] = 0;
+    for (uint64_t bits = table[w]; bits; bits &= bits - 1) {
+      uint pat = w * 64 + __builtin_ctzll(bits);
+      if ((pat & black) == black && (pat & white) == 0)
+        alive[w] |= bits & -bits;
+    }
+  }
+}
+
+/* ************************************************************************** */
+
+/* Projects a pattern on the cells shared by a pair of constraints, given the
+ * positions of the shared cells in the pattern. */
+static uint _project(uint pat, const uint8_t* pos, uint n) {
+  uint proj = 0;
+  for (uint t = 0; t < n; t++) proj |= ((pat >> pos[t]) & 1u) << t;
+  return proj;
+}
+
+/* ************************************************************************** */
+/*                               TABLE ENGINE                                 */
+/* ************************************************************************** */
+
+void tables_init(solver* s) {
+  // feasible patterns of each constraint
+  s->cons_patterns =
+      (uint64_t*)calloc(s->nb_cons * PATTERN_WORDS + 1, sizeof(uint64_t));
+  assert(s->cons_patterns);
+  for (uint k = 0; k < s->nb_cons; k++) {
+    uint64_t* table = s->cons_patterns + k * PATTERN_WORDS;
+    uint m = s->cons_start[k + 1] - s->cons_start[k];
+    int need = s->cons_need[k];
+    bool weighted = false;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++)
+      if (s->cons_weights[p] != 1) weighted = true;
+    if (!weighted) {
+      // tabulated: keep the patterns using the first m cells only
+      if (need < 0 || need > 9) continue;
+      for (uint w = 0; w < PATTERN_WORDS; w++) {
+        uint64_t range = 0;
+        if (m >= 6)
+          range = (w < (1u << (m - 6))) ? ~0ULL : 0;
+        else if (w == 0)
+          range = (1ULL << (1u << m)) - 1;
+        table[w] = POPCOUNT_PATTERNS[need][w] & range;
+      }
+    } else {
+      // on small wrapping grids, a cell may count several times
+      for (uint pat = 0; pat < (1u << m); pat++) {
+        int nb = 0;
+        for (uint i = 0; i < m; i++)
+          if (pat & (1u << i)) nb += s->cons_weights[s->cons_start[k] + i];
+        if (nb == need) table[pat / 64] |= 1ULL << (pat % 64);
+      }
+    }
+  }
+
+  // pairs of constraints sharing cells
+  uint* last = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  uint* slot = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  assert(last && slot);
+  for (uint l = 0; l < s->nb_cons; l++) last[l] = s->nb_cons;
+  s->nb_pairs = 0;
+  for (uint k = 0; k < s->nb_cons; k++)
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      for (uint q = s->cell_start[x]; q < s->cell_start[x + 1]; q++) {
+        uint l = s->cell_cons[q];
+        if (l != k && last[l] != k) {
+          last[l] = k;
+          s->nb_pairs++;
+        }
+      }
+    }
+  s->pair_start = (uint*)malloc((s->nb_cons + 1) * sizeof(uint));
+  s->pair_cons = (uint*)malloc((s->nb_pairs + 1) * sizeof(uint));
+  s->pair_pos = (uint8_t*)malloc((s->nb_pairs + 1) * PAIR_BYTES);
+  assert(s->pair_start && s->pair_cons && s->pair_pos);
+
+  // positions of the shared cells in both constraints
+  for (uint l = 0; l < s->nb_cons; l++) last[l] = s->nb_cons;
+  uint nb_pairs = 0;
+  for (uint k = 0; k < s->nb_cons; k++) {
+    s->pair_start[k] = nb_pairs;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p];
+      for (uint q = s->cell_start[x]; q < s->cell_start[x + 1]; q++) {
+        uint l = s->cell_cons[q];
+        if (l == k) continue;
+        if (last[l] != k) {
+          last[l] = k;
+          slot[l] = nb_pairs;
+          s->pair_cons[nb_pairs] = l;
+          s->pair_pos[nb_pairs++ * PAIR_BYTES] = 0;
+        }
+        uint8_t* pos = s->pair_pos + slot[l] * PAIR_BYTES;
+        uint j = s->cons_start[l];
+        while (s->cons_cells[j] != x) j++;
+        uint t = pos[0]++;
+        pos[1 + t] = p - s->cons_start[k];
+        pos[10 + t] = j - s->cons_start[l];
+      }
+    }
+  }
+  s->pair_start[s->nb_cons] = nb_pairs;
+  free(slot);
+  free(last);
+}
+
+/* ************************************************************************** */
+
+bool tables_propagate(solver* s) {
+  uint64_t alive[PATTERN_WORDS], other[PATTERN_WORDS], support[PATTERN_WORDS];
+  while (s->tqueue_size > 0) {
+    uint k = s->tqueue[--s->tqueue_size];
+    s->tqueued[k] = false;
+    if (s->cons_empty[k] == 0) continue;
+    _alive(s, k, alive);
+
+    // keep the patterns supported by each overlapping constraint
+    for (uint r = s->pair_start[k]; r < s->pair_start[k + 1]; r++) {
+      uint l = s->pair_cons[r];
+      if (s->cons_empty[l] == 0) continue;
+      const uint8_t* pos = s->pair_pos + r * PAIR_BYTES;
+      uint n = pos[0];
+      _alive(s, l, other);
+      memset(support, 0, sizeof(support));
+      for (uint w = 0; w < PATTERN_WORDS; w++)
+        for (uint64_t bits = other[w]; bits; bits &= bits - 1) {
+          uint proj = _project(w * 64 + __builtin_ctzll(bits), pos + 10, n);
+          support[proj / 64] |= 1ULL << (proj % 64);
+        }
+      for (uint w = 0; w < PATTERN_WORDS; w++)
+        for (uint64_t bits = alive[w]; bits; bits &= bits - 1) {
+          uint proj = _project(w * 64 + __builtin_ctzll(bits), pos + 1, n);
+          if (!(support[proj / 64] & (1ULL << (proj % 64))))
+            alive[w] &= ~(bits & -bits);
+        }
+    }
+
+    // cells with the same color in all the remaining patterns
+    uint all = 0x1FF, any = 0;
+    bool empty = true;
+    for (uint w = 0; w < PATTERN_WORDS; w++)
+      for (uint64_t bits = alive[w]; bits; bits &= bits - 1) {
+        uint pat = w * 64 + __builtin_ctzll(bits);
+        all &= pat;
+        any |= pat;
+        empty = false;
+      }
+    if (empty) return false;
+
+    bool forced = false;
+    for (uint p = s->cons_start[k]; p < s->cons_start[k + 1]; p++) {
+      uint x = s->cons_cells[p], i = p - s->cons_start[k];
+      if (s->colors[x] != EMPTY) continue;
+      if (all & (1u << i)) {
+        if (!solver_assign(s, x, BLACK)) return false;
+        forced = true;
+      } else if (!(any & (1u << i))) {
+        if (!solver_assign(s, x, WHITE)) return false;
+        forced = true;
+      }
+    }
+    if (forced) return true;  // back to the counters
+  }
+  return true;
+}
+
+/* ************************************************************************** */
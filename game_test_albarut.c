@@ -6,6 +6,7 @@
 #include "game.h"
 #include "game_aux.h"
 #include "game_ext.h"
+#include "game_random.h"
 #include "game_struct.h"
 #include "game_tools.h"
 
@@ -74,6 +75,40 @@ bool test_game_print() {
   return true;
 }
 
+/* ********** TEST GAME TO STRING ********** */
+
+bool test_game_to_string() {
+  game g = game_new_empty_ext(2, 3, false, FULL);
+  game_set_constraint(g, 0, 1, 2);
+  game_set_color(g, 0, 1, BLACK);
+  game_set_color(g, 1, 2, WHITE);
+  char *str = game_to_string(g);
+  ASSERT(str);
+  ASSERT(strcmp(str,
+                "     0 1 2 \n"
+                "     ------\n"
+                "  0 |  \u2777   |\n"
+                "  1 |    \u25a1 |\n"
+                "     ------\n") == 0);
+  free(str);
+
+  // same text on any stream
+  FILE *f = fopen("test_file_print.txt", "w");
+  ASSERT(f);
+  game_print_to(g, f);
+  fclose(f);
+  f = fopen("test_file_print.txt", "r");
+  ASSERT(f);
+  char line[64];
+  ASSERT(fgets(line, sizeof(line), f) != NULL);
+  ASSERT(strcmp(line, "     0 1 2 \n") == 0);
+  fclose(f);
+  remove("test_file_print.txt");
+
+  game_delete(g);
+  return true;
+}
+
 /* ********** TEST GAME EQUAL ********** */
 
 bool test_game_equal() {
@@ -207,6 +242,34 @@ bool test_game_save() {
   return test;
 }
 
+/* ********** SHARED GAMES ********** */
+
+/* Builds a square game with the clues of a pseudo-random coloring (drawn with
+ * rand), each of them kept with probability 1 / keep. */
+static game random_clues(uint n, bool wrapping, neighbourhood neigh,
+                         uint keep) {
+  game sol = game_new_empty_ext(n, n, wrapping, neigh);
+  for (uint i = 0; i < n; i++)
+    for (uint j = 0; j < n; j++)
+      game_set_color(sol, i, j, rand() % 2 ? BLACK : WHITE);
+  game g = game_new_empty_ext(n, n, wrapping, neigh);
+  for (uint i = 0; i < n; i++)
+    for (uint j = 0; j < n; j++)
+      if (rand() % keep == 0)
+        game_set_constraint(g, i, j, game_nb_neighbors(sol, i, j, BLACK));
+  game_delete(sol);
+  return g;
+}
+
+/* Builds a game without solution: the center needs its whole orthogonal
+ * neighbourhood black, the 0 of a corner clears two of those cells. */
+static game no_solution_game(void) {
+  game g = game_new_empty_ext(3, 3, false, ORTHO);
+  game_set_constraint(g, 1, 1, 5);
+  game_set_constraint(g, 0, 0, 0);
+  return g;
+}
+
 /* ********** TEST GAME SOLVE ********** */
 
 bool test_game_solve() {
@@ -245,6 +308,317 @@ bool test_game_solve() {
   ASSERT(game_won(g5));
   game_delete(g5);
 
+  // no solution: the game must be unchanged
+  game g6 = game_new_empty_ext(2, 2, false, FULL);
+  ASSERT(g6);
+  game_set_constraint(g6, 0, 0, 3);
+  game_set_constraint(g6, 1, 1, 0);
+  game_set_color(g6, 0, 1, BLACK);
+  game g7 = game_copy(g6);
+  ASSERT(game_solve(g6) == false);
+  ASSERT(game_equal(g6, g7));
+  game_delete(g6);
+  game_delete(g7);
+
+  return true;
+}
+
+/* ********** TEST GAME SOLVE LARGE ********** */
+
+bool test_game_solve_large() {
+  // all the clues of a pseudo-random coloring, far deeper than the call stack
+  srand(42);
+  game g = random_clues(400, false, FULL, 1);
+  ASSERT(game_solve(g) == true);
+  ASSERT(game_won(g));
+  game_delete(g);
+
+  // half of the clues: the search has to branch, and restarts away from the
+  // subtrees where it used to get lost
+  uint seeds[] = {1, 8};
+  for (uint k = 0; k < 2; k++) {
+    srand(seeds[k]);
+    game g1 = game_random(20, 20, false, FULL, false, 0.5, 0.5);
+    solver_stats stats;
+    solver_options opts = {SOLVER_SEARCH, 0, 0, PROPAGATION_DEFAULT, &stats};
+    ASSERT(game_solve_ext(g1, &opts) == true);
+    ASSERT(game_won(g1));
+    ASSERT(stats.nb_nodes > 0);
+    game_delete(g1);
+  }
+  return true;
+}
+
+/* ********** TEST GAME SOLVE EXT ********** */
+
+bool test_game_solve_ext() {
+  solver_options opts = {SOLVER_SEARCH, 4};
+  game g = game_default();
+  ASSERT(game_solve_ext(g, &opts) == true);
+  ASSERT(game_won(g));
+  game g1 = game_default_solution();
+  ASSERT(game_equal(g, g1));
+  game_delete(g);
+  game_delete(g1);
+
+  // many solutions: any of them is fine
+  game g2 = game_new_empty_ext(6, 6, true, FULL_EXCLUDE);
+  game_set_constraint(g2, 0, 0, 4);
+  game_set_constraint(g2, 3, 3, 2);
+  ASSERT(game_solve_ext(g2, &opts) == true);
+  ASSERT(game_won(g2));
+  game_delete(g2);
+
+  // no solution: the game is unchanged
+  game g3 = no_solution_game();
+  game g4 = game_copy(g3);
+  ASSERT(game_solve_ext(g3, &opts) == false);
+  ASSERT(game_equal(g3, g4));
+  game_delete(g3);
+  game_delete(g4);
+
+  return true;
+}
+
+/* ********** TEST GAME SOLVE CDCL ********** */
+
+bool test_game_solve_cdcl() {
+  solver_stats stats;
+  solver_options opts = {SOLVER_CDCL, 0, 0, PROPAGATION_DEFAULT, &stats};
+  game g = game_default();
+  ASSERT(game_solve_ext(g, &opts) == true);
+  game g1 = game_default_solution();
+  ASSERT(game_equal(g, g1));
+  game_delete(g);
+  game_delete(g1);
+
+  // half of the clues of a pseudo-random coloring, in every neighbourhood
+  srand(7);
+  for (neighbourhood neigh = FULL; neigh <= ORTHO_EXCLUDE; neigh++) {
+    game g2 = random_clues(40, neigh % 2, neigh, 2);
+    ASSERT(game_solve_ext(g2, &opts) == true);
+    ASSERT(game_won(g2));
+    game_delete(g2);
+  }
+
+  // the default engine of a sequential solve is the conflict-driven one
+  srand(2);
+  game g5 = game_random(30, 30, false, FULL, false, 0.5, 0.5);
+  solver_options auto_opts = {SOLVER_AUTO, 0, 0, PROPAGATION_DEFAULT, &stats};
+  ASSERT(game_solve_ext(g5, &auto_opts) == true);
+  ASSERT(game_won(g5));
+  ASSERT(stats.nb_conflicts > 0);
+  game_delete(g5);
+
+  // no solution: the game is unchanged
+  game g3 = no_solution_game();
+  game g4 = game_copy(g3);
+  ASSERT(game_solve_ext(g3, &opts) == false);
+  ASSERT(game_equal(g3, g4));
+  game_delete(g3);
+  game_delete(g4);
+  return true;
+}
+
+/* ********** TEST GAME SOLVE LOGIC ********** */
+
+/* Sets the clues of a game from strings, '-' for unconstrained squares. */
+static void set_clues(game g, const char *rows[]) {
+  for (uint i = 0; i < game_nb_rows(g); i++)
+    for (uint j = 0; j < game_nb_cols(g); j++)
+      if (rows[i][j] != '-') game_set_constraint(g, i, j, rows[i][j] - '0');
+}
+
+/* Solves a game with the logical solver, and checks the deductions against
+ * its unique solution. */
+static difficulty solve_logic_checked(game g) {
+  game sol = game_copy(g);
+  ASSERT(game_solve(sol));
+  difficulty grade = game_grade(g);
+  deduction *steps;
+  uint nb_steps;
+  difficulty d = game_solve_logic(g, &steps, &nb_steps);
+  ASSERT(d == grade);
+  ASSERT(nb_steps == game_nb_rows(g) * game_nb_cols(g));
+  for (uint t = 0; t < nb_steps; t++) {
+    ASSERT(steps[t].c == game_get_color(sol, steps[t].i, steps[t].j));
+    ASSERT((difficulty)steps[t].rule <= d);
+  }
+  ASSERT(game_equal(g, sol));
+  free(steps);
+  game_delete(sol);
+  return d;
+}
+
+bool test_game_solve_logic() {
+  game g = game_default();
+  ASSERT(solve_logic_checked(g) != DIFFICULTY_UNSOLVED);
+  ASSERT(game_won(g));
+  game_delete(g);
+
+  // one 0 clue
+  g = game_new_empty_ext(3, 3, false, FULL);
+  game_set_constraint(g, 1, 1, 0);
+  ASSERT(solve_logic_checked(g) == DIFFICULTY_TRIVIAL);
+  game_delete(g);
+
+  // overlapping clues
+  const char *medium[] = {"--31", "224-", "--2-"};
+  g = game_new_empty_ext(3, 4, false, FULL);
+  set_clues(g, medium);
+  ASSERT(game_grade(g) == DIFFICULTY_MEDIUM);
+  ASSERT(solve_logic_checked(g) == DIFFICULTY_MEDIUM);
+  game_delete(g);
+
+  // a chain is needed
+  const char *hard[] = {"342-", "-643", "-6--", "3-5-"};
+  g = game_new_empty_ext(4, 4, false, FULL);
+  set_clues(g, hard);
+  ASSERT(solve_logic_checked(g) == DIFFICULTY_HARD);
+  game_delete(g);
+
+  // several solutions: nothing to deduce
+  g = game_new_empty_ext(4, 4, false, FULL);
+  game g1 = game_copy(g);
+  deduction *steps;
+  uint nb_steps;
+  ASSERT(game_solve_logic(g, &steps, &nb_steps) == DIFFICULTY_UNSOLVED);
+  ASSERT(nb_steps == 0);
+  ASSERT(game_equal(g, g1));
+  free(steps);
+  game_delete(g);
+  game_delete(g1);
+
+  // no solution: the game is unchanged
+  g = no_solution_game();
+  g1 = game_copy(g);
+  ASSERT(game_solve_logic(g, NULL, NULL) == DIFFICULTY_UNSOLVED);
+  ASSERT(game_equal(g, g1));
+  game_delete(g);
+  game_delete(g1);
+  return true;
+}
+
+/* ********** TEST GAME HINT ********** */
+
+bool test_game_hint() {
+  game g = game_default();
+  game sol = game_default_solution();
+  uint i, j, clue_i, clue_j;
+  color c;
+  ASSERT(game_hint(g, &i, &j, &c, &clue_i, &clue_j));
+  ASSERT(game_get_color(sol, i, j) == c);
+  ASSERT(game_get_constraint(g, clue_i, clue_j) != UNCONSTRAINED);
+  int di = (int)i - (int)clue_i, dj = (int)j - (int)clue_j;
+  ASSERT(di >= -1 && di <= 1 && dj >= -1 && dj <= 1);
+
+  // play the hints up to the solution, undoing some moves on the way
+  hint_state h = hint_new(g);
+  deduction d;
+  uint nb = 0;
+  while (hint_next(h, g, &d)) {
+    ASSERT(game_get_color(g, d.i, d.j) == EMPTY);
+    ASSERT(game_get_color(sol, d.i, d.j) == d.c);
+    ASSERT(game_get_constraint(g, d.clue_i, d.clue_j) != UNCONSTRAINED);
+    game_play_move(g, d.i, d.j, d.c);
+    if (++nb % 5 == 0) game_undo(g);
+    ASSERT(nb < 100);
+  }
+  ASSERT(game_won(g));
+  hint_delete(h);
+  ASSERT(!game_hint(g, &i, &j, &c, NULL, NULL));
+
+  // the colors break a clue
+  game_delete(g);
+  g = game_new_empty_ext(3, 3, false, FULL);
+  game_set_constraint(g, 1, 1, 0);
+  h = hint_new(g);
+  ASSERT(hint_next(h, g, &d) && d.c == WHITE && d.rule == RULE_TRIVIAL);
+  game_play_move(g, 0, 0, BLACK);
+  ASSERT(!hint_next(h, g, &d));
+  game_undo(g);
+  ASSERT(hint_next(h, g, &d) && d.c == WHITE);
+  hint_delete(h);
+  game_delete(g);
+  game_delete(sol);
+  return true;
+}
+
+/* Copies a game, keeping the clues of the given squares only. */
+static game keep_clues(cgame g, const uint *clues, uint nb_clues) {
+  game h = game_copy(g);
+  uint nb_cols = game_nb_cols(g);
+  for (uint q = 0; q < game_nb_rows(g) * nb_cols; q++) {
+    bool kept = false;
+    for (uint t = 0; t < nb_clues; t++) kept = kept || clues[t] == q;
+    if (!kept) game_set_constraint(h, q / nb_cols, q % nb_cols, UNCONSTRAINED);
+  }
+  return h;
+}
+
+bool test_game_dead_end() {
+  game g = game_default();
+  game sol = game_default_solution();
+  uint *clues, nb_clues;
+  ASSERT(game_dead_end(g, 1000, &clues, &nb_clues) == DEADEND_NONE);
+  ASSERT(clues == NULL && nb_clues == 0);
+
+  // each wrong move is a dead end, the default game having one solution
+  for (uint i = 0; i < game_nb_rows(g); i++)
+    for (uint j = 0; j < game_nb_cols(g); j++) {
+      color c = game_get_color(sol, i, j) == BLACK ? WHITE : BLACK;
+      game_play_move(g, i, j, c);
+      ASSERT(game_dead_end(g, 1000, &clues, &nb_clues) == DEADEND_FOUND);
+      ASSERT(nb_clues > 0);
+      // the clues are a dead end on their own, and a minimal one
+      game h = keep_clues(g, clues, nb_clues);
+      uint *clues2, nb_clues2;
+      ASSERT(game_dead_end(h, 1000, &clues2, &nb_clues2) == DEADEND_FOUND);
+      ASSERT(nb_clues2 == nb_clues);
+      free(clues2);
+      game_delete(h);
+      for (uint t = 0; t < nb_clues; t++) {
+        uint q = clues[t];
+        uint nb_cols = game_nb_cols(g);
+        ASSERT(game_get_constraint(g, q / nb_cols, q % nb_cols) !=
+               UNCONSTRAINED);
+        clues[t] = clues[nb_clues - 1];
+        h = keep_clues(g, clues, nb_clues - 1);
+        ASSERT(game_dead_end(h, 1000, &clues2, &nb_clues2) == DEADEND_NONE);
+        game_delete(h);
+        clues[t] = q;
+      }
+      free(clues);
+      game_undo(g);
+    }
+  game_delete(sol);
+  game_delete(g);
+
+  // a broken clue is a dead end on its own
+  g = game_new_empty_ext(3, 3, false, FULL);
+  game_set_constraint(g, 1, 1, 0);
+  game_set_constraint(g, 0, 2, 1);
+  game_play_move(g, 0, 0, BLACK);
+  ASSERT(game_dead_end(g, 0, &clues, &nb_clues) == DEADEND_FOUND);
+  ASSERT(nb_clues == 1 && clues[0] == 4);
+  free(clues);
+  game_delete(g);
+
+  // the rules are not enough without search
+  const char *hard[] = {"342-", "-643", "-6--", "3-5-"};
+  g = game_new_empty_ext(4, 4, false, FULL);
+  set_clues(g, hard);
+  ASSERT(game_dead_end(g, 0, &clues, &nb_clues) == DEADEND_UNKNOWN);
+  ASSERT(clues == NULL && nb_clues == 0);
+  ASSERT(game_dead_end(g, 1000, &clues, &nb_clues) == DEADEND_NONE);
+  game_delete(g);
+
+  // a large component costs its size before any search
+  srand(3);
+  g = random_clues(100, false, FULL, 2);
+  ASSERT(game_dead_end(g, 100, &clues, &nb_clues) == DEADEND_UNKNOWN);
+  ASSERT(clues == NULL && nb_clues == 0);
+  game_delete(g);
   return true;
 }
 
@@ -274,6 +648,8 @@ int main(int argc, char *argv[]) {
     ok = test_game_default_solution();
   } else if (strcmp("game_print", argv[1]) == 0) {
     ok = test_game_print();
+  } else if (strcmp("game_to_string", argv[1]) == 0) {
+    ok = test_game_to_string();
   } else if (strcmp("game_equal", argv[1]) == 0) {
     ok = test_game_equal();
   } else if (strcmp("game_new_empty", argv[1]) == 0) {
@@ -290,6 +666,18 @@ int main(int argc, char *argv[]) {
     ok = test_game_save();
   } else if (strcmp("game_solve", argv[1]) == 0) {
     ok = test_game_solve();
+  } else if (strcmp("game_solve_large", argv[1]) == 0) {
+    ok = test_game_solve_large();
+  } else if (strcmp("game_solve_ext", argv[1]) == 0) {
+    ok = test_game_solve_ext();
+  } else if (strcmp("game_solve_cdcl", argv[1]) == 0) {
+    ok = test_game_solve_cdcl();
+  } else if (strcmp("game_solve_logic", argv[1]) == 0) {
+    ok = test_game_solve_logic();
+  } else if (strcmp("game_hint", argv[1]) == 0) {
+    ok = test_game_hint();
+  } else if (strcmp("game_dead_end", argv[1]) == 0) {
+    ok = test_game_dead_end();
   } else {
     fprintf(stderr, "Error: test \"%s\" not found!\n", argv[1]);
     exit(EXIT_FAILURE);
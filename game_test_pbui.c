@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -5,6 +6,7 @@
 
 #include "game.h"
 #include "game_aux.h"
+#include "game_diagram.h"
 #include "game_ext.h"
 #include "game_tools.h"
 
@@ -41,8 +43,29 @@ bool test_game_won() {
   bool test2 = !game_won(g2);
   ASSERT(test2);
 
+  // a wrapping grid with two words per row: once the grid is full, only the
+  // numbered squares are checked, so the empty square in the last, partial
+  // word must be seen
+  game g3 = game_new_empty_ext(3, 70, true, FULL);
+  for (uint i = 0; i < 3; i++)
+    for (uint j = 0; j < 70; j++)
+      game_set_color(g3, i, j, (i + j) % 3 == 0 ? BLACK : WHITE);
+  uint cols[] = {0, 1, 63, 64, 68, 69};
+  for (uint i = 0; i < 3; i++)
+    for (uint k = 0; k < 6; k++)
+      game_set_constraint(g3, i, cols[k],
+                          game_nb_neighbors(g3, i, cols[k], BLACK));
+  ASSERT(game_won(g3));
+  game_set_color(g3, 1, 66, EMPTY);
+  ASSERT(!game_won(g3));
+  game_set_color(g3, 1, 66, WHITE);
+  ASSERT(game_won(g3));
+  game_set_constraint(g3, 1, 64, game_get_constraint(g3, 1, 64) + 1);
+  ASSERT(!game_won(g3));
+
   game_delete(g1);
   game_delete(g2);
+  game_delete(g3);
   return test1 && test2;
 }
 
@@ -69,9 +92,40 @@ bool test_game_nb_neighbors() {
   game_set_color(g2, 0, 1, WHITE);
   int result2 = game_nb_neighbors(g2, 0, 0, WHITE);
   ASSERT(result2 == 2);
+
+  // a wrapping grid of 3x70: the windows cross the word boundary between
+  // columns 63 and 64, and the seam between columns 69 and 0
+  game g3 = game_new_empty_ext(3, 70, true, FULL);
+  game_set_color(g3, 0, 63, BLACK);
+  game_set_color(g3, 0, 64, BLACK);
+  game_set_color(g3, 1, 0, BLACK);
+  game_set_color(g3, 1, 69, BLACK);
+  game_set_color(g3, 2, 63, BLACK);
+  uint squares[6][2] = {{1, 63}, {1, 64}, {1, 0}, {1, 69}, {0, 64}, {2, 0}};
+  int expected[4][6] = {[FULL] = {3, 3, 2, 2, 3, 2},
+                        [ORTHO] = {2, 1, 2, 2, 2, 1},
+                        [FULL_EXCLUDE] = {3, 3, 1, 1, 2, 2},
+                        [ORTHO_EXCLUDE] = {2, 1, 1, 1, 1, 1}};
+  int sizes[4] = {[FULL] = 9, [ORTHO] = 5, [FULL_EXCLUDE] = 8,
+                  [ORTHO_EXCLUDE] = 4};
+  for (neighbourhood neigh = FULL; neigh <= ORTHO_EXCLUDE; neigh++) {
+    game g4 = game_new_empty_ext(3, 70, true, neigh);
+    for (uint i = 0; i < 3; i++)
+      for (uint j = 0; j < 70; j++)
+        game_set_color(g4, i, j, game_get_color(g3, i, j));
+    for (uint k = 0; k < 6; k++) {
+      uint i = squares[k][0], j = squares[k][1];
+      ASSERT(game_nb_neighbors(g4, i, j, BLACK) == expected[neigh][k]);
+      ASSERT(game_nb_neighbors(g4, i, j, EMPTY) ==
+             sizes[neigh] - expected[neigh][k]);
+      ASSERT(game_nb_neighbors(g4, i, j, WHITE) == 0);
+    }
+    game_delete(g4);
+  }
   game_delete(g);
   game_delete(g1);
   game_delete(g2);
+  game_delete(g3);
   return true;
 }
 
@@ -179,17 +233,842 @@ bool test_game_nb_solutions() {
   game g = game_new_empty_ext(2, 2, false, FULL);
   game_set_constraint(g, 0, 0, 1);
   ASSERT(g);
-  uint solutions = game_nb_solutions(g);
+  uint64_t solutions = game_nb_solutions(g);
   ASSERT(solutions == 4);
   game_delete(g);
 
   game g2 = game_default();
   ASSERT(g2);
-  uint solutions2 = game_nb_solutions(g2);
+  uint64_t solutions2 = game_nb_solutions(g2);
   ASSERT(solutions2 == 1);
   game_delete(g2);
+
+  // no constraint at all: every coloring is a solution
+  game g3 = game_new_empty_ext(3, 4, false, FULL);
+  ASSERT(g3);
+  ASSERT(game_nb_solutions(g3) == ((uint64_t)1 << 12));
+  game_delete(g3);
+
+  // a wrapping grid with a fifth of the clues of a coloring
+  game sol = game_new_empty_ext(8, 8, true, FULL);
+  game g4 = game_new_empty_ext(8, 8, true, FULL);
+  for (uint i = 0; i < 8; i++)
+    for (uint j = 0; j < 8; j++)
+      game_set_color(sol, i, j, (i * j + 2 * i + j) % 3 == 0 ? BLACK : WHITE);
+  for (uint i = 0; i < 8; i++)
+    for (uint j = 0; j < 8; j++)
+      if ((i + 3 * j) % 5 == 0)
+        game_set_constraint(g4, i, j, game_nb_neighbors(sol, i, j, BLACK));
+  solver_options cache = {SOLVER_CACHE};
+  bigint *nb = game_nb_solutions_ext(g4, &cache);
+  ASSERT(game_nb_solutions(g4) == bigint_to_u64(nb));
+  bigint_free(nb);
+  game_delete(g4);
+  game_delete(sol);
+  return true;
+}
+/* ********** TEST GAME NB SOLUTIONS EXT ********** */
+bool test_game_nb_solutions_ext() {
+  solver_options search = {SOLVER_SEARCH};
+  solver_options rowdp = {SOLVER_ROWDP};
+  solver_options parallel = {SOLVER_SEARCH, 3};
+
+  // both engines agree, with or without wrapping
+  for (neighbourhood n = FULL; n <= ORTHO_EXCLUDE; n++) {
+    for (int w = 0; w <= 1; w++) {
+      game g = game_new_empty_ext(4, 5, w, n);
+      game_set_constraint(g, 0, 0, 1);
+      game_set_constraint(g, 1, 2, 3);
+      game_set_constraint(g, 3, 4, 2);
+      game_set_constraint(g, 2, 1, 0);
+      bigint *nb1 = game_nb_solutions_ext(g, &search);
+      bigint *nb2 = game_nb_solutions_ext(g, &rowdp);
+      bigint *nb3 = game_nb_solutions_ext(g, &parallel);
+      ASSERT(bigint_cmp(nb1, nb2) == 0);
+      ASSERT(bigint_cmp(nb1, nb3) == 0);
+      bigint_free(nb3);
+      ASSERT(bigint_to_u64(nb1) == game_nb_solutions(g));
+      bigint_free(nb1);
+      bigint_free(nb2);
+      game_delete(g);
+    }
+  }
+
+  // more solutions than 64 bits can count
+  game g = game_new_empty_ext(10, 10, false, FULL);
+  bigint *nb = game_nb_solutions_ext(g, &rowdp);
+  char *str = bigint_to_string(nb);
+  ASSERT(strcmp(str, "1267650600228229401496703205376") == 0);  // 2^100
+  ASSERT(game_nb_solutions(g) == UINT64_MAX);
+  free(str);
+  bigint_free(nb);
+  nb = game_nb_solutions_ext(g, &search);  // one component per cell
+  str = bigint_to_string(nb);
+  ASSERT(strcmp(str, "1267650600228229401496703205376") == 0);
+  free(str);
+  bigint_free(nb);
+  game_delete(g);
+
+  game g2 = game_default();
+  nb = game_nb_solutions_ext(g2, NULL);
+  ASSERT(bigint_to_u64(nb) == 1);
+  bigint_free(nb);
+  game_delete(g2);
+  return true;
+}
+
+/* ********** TEST GAME NB SOLUTIONS COMPONENTS ********** */
+
+bool test_game_nb_solutions_components() {
+  // two 5x6 halves, whose clues never share a cell
+  game g = game_new_empty_ext(5, 12, false, FULL);
+  game left = game_new_empty_ext(5, 6, false, FULL);
+  game right = game_new_empty_ext(5, 6, false, FULL);
+  for (int i = 0; i < 5; i++)
+    for (int j = 0; j < 12; j++) {
+      if (j == 5 || j == 6) continue;
+      // clues of a fixed coloring
+      uint nb = 0;
+      for (int ii = i - 1; ii <= i + 1; ii++)
+        for (int jj = j - 1; jj <= j + 1; jj++)
+          if (ii >= 0 && ii < 5 && jj >= 0 && jj < 12 &&
+              (ii * 7 + jj * 3) % 5 < 2)
+            nb++;
+      game_set_constraint(g, i, j, nb);
+      if (j < 5)
+        game_set_constraint(left, i, j, nb);
+      else
+        game_set_constraint(right, i, j - 6, nb);
+    }
+
+  solver_options search = {SOLVER_SEARCH};
+  uint64_t nb_left = game_nb_solutions(left);
+  uint64_t nb_right = game_nb_solutions(right);
+  ASSERT(nb_left > 0 && nb_right > 0);
+  bigint *nb = game_nb_solutions_ext(g, &search);
+  ASSERT(bigint_to_u64(nb) == nb_left * nb_right);
+  bigint_free(nb);
+
+  ASSERT(game_solve(g) == true);
+  ASSERT(game_won(g));
+
+  game_delete(g);
+  game_delete(left);
+  game_delete(right);
+  return true;
+}
+
+/* ********** TEST GAME NB SOLUTIONS FREE ********** */
+
+bool test_game_nb_solutions_free() {
+  // one clue forces 4 white cells, the 96 other cells are free
+  game g = game_new_empty_ext(10, 10, false, FULL);
+  game_set_constraint(g, 0, 0, 0);
+  solver_options search = {SOLVER_SEARCH};
+  bigint *nb = game_nb_solutions_ext(g, &search);
+  bigint *expected = bigint_new(1);
+  bigint_shl(expected, 96);
+  ASSERT(bigint_cmp(nb, expected) == 0);
+  bigint_free(nb);
+  bigint_free(expected);
+  ASSERT(game_nb_solutions(g) == UINT64_MAX);
+
+  // free cells are filled in white
+  ASSERT(game_solve(g) == true);
+  ASSERT(game_won(g));
+  for (uint i = 0; i < 10; i++)
+    for (uint j = 0; j < 10; j++) ASSERT(game_get_color(g, i, j) == WHITE);
+  game_delete(g);
+
+  // free cells next to a constrained region
+  game g2 = game_new_empty_ext(3, 6, false, ORTHO);
+  game_set_constraint(g2, 1, 1, 2);
+  uint64_t nb2 = game_nb_solutions(g2);
+  ASSERT(nb2 == 10 * (1 << 13));  // C(5,2) times 2^13
+  game_delete(g2);
+  return true;
+}
+
+/* ********** TEST GAME NB SOLUTIONS CLASSES ********** */
+
+bool test_game_nb_solutions_classes() {
+  // two overlapping clues: 3 classes of 3, 6 and 3 cells, 69 free cells
+  game g = game_new_empty_ext(9, 9, false, FULL);
+  game_set_constraint(g, 1, 1, 3);
+  game_set_constraint(g, 1, 2, 4);
+  solver_options search = {SOLVER_SEARCH};
+  bigint *nb = game_nb_solutions_ext(g, &search);
+  bigint *expected = bigint_new(213);  // sum of C(3,b0).C(6,b1).C(3,b2)
+  bigint_shl(expected, 69);
+  ASSERT(bigint_cmp(nb, expected) == 0);
+  bigint_free(nb);
+  bigint_free(expected);
+  game_delete(g);
+
+  // sparse clues, with or without wrapping: same count as the row DP
+  solver_options rowdp = {SOLVER_ROWDP};
+  for (int w = 0; w <= 1; w++) {
+    game g2 = game_new_empty_ext(6, 8, w, FULL);
+    game_set_constraint(g2, 0, 0, 2);
+    game_set_constraint(g2, 1, 1, 5);
+    game_set_constraint(g2, 4, 2, 3);
+    game_set_constraint(g2, 3, 6, 4);
+    game_set_constraint(g2, 5, 7, 1);
+    bigint *nb1 = game_nb_solutions_ext(g2, &search);
+    bigint *nb2 = game_nb_solutions_ext(g2, &rowdp);
+    ASSERT(bigint_cmp(nb1, nb2) == 0);
+    bigint_free(nb1);
+    bigint_free(nb2);
+    game_delete(g2);
+  }
+  return true;
+}
+
+/* ********** TEST GAME NB SOLUTIONS CACHE ********** */
+
+bool test_game_nb_solutions_cache() {
+  solver_options rowdp = {SOLVER_ROWDP};
+  solver_options cache = {SOLVER_CACHE};
+  solver_options tiny = {SOLVER_CACHE, 0, 1024};  // forces evictions
+
+  for (neighbourhood n = FULL; n <= ORTHO_EXCLUDE; n++)
+    for (int w = 0; w <= 1; w++) {
+      game g = game_new_empty_ext(6, 7, w, n);
+      for (uint i = 0; i < 6; i++)
+        for (uint j = 0; j < 7; j++)
+          if ((i * 7 + j * 3) % 4 != 0)
+            game_set_constraint(g, i, j, (i + j) % 3);
+      bigint *nb1 = game_nb_solutions_ext(g, &rowdp);
+      bigint *nb2 = game_nb_solutions_ext(g, &cache);
+      bigint *nb3 = game_nb_solutions_ext(g, &tiny);
+      ASSERT(bigint_cmp(nb1, nb2) == 0);
+      ASSERT(bigint_cmp(nb1, nb3) == 0);
+      bigint_free(nb1);
+      bigint_free(nb2);
+      bigint_free(nb3);
+      game_delete(g);
+    }
+
+  game g = game_default();
+  bigint *nb = game_nb_solutions_ext(g, &cache);
+  ASSERT(bigint_to_u64(nb) == 1);
+  bigint_free(nb);
+  game_delete(g);
+
+  // a wrapping grid with a fifth of the clues: more threads keep the cache
+  // engine (the parallel search took minutes)
+  solver_options one = {SOLVER_AUTO};
+  solver_options three = {SOLVER_AUTO, 3};
+  solver_options rowdp3 = {SOLVER_ROWDP, 3};
+  g = game_new_empty_ext(10, 10, true, FULL);
+  game sol = game_new_empty_ext(10, 10, true, FULL);
+  for (uint i = 0; i < 10; i++)
+    for (uint j = 0; j < 10; j++)
+      game_set_color(sol, i, j, (i * j + 2 * i + j) % 3 == 0 ? BLACK : WHITE);
+  for (uint i = 0; i < 10; i++)
+    for (uint j = 0; j < 10; j++)
+      if ((i * 7 + j * 3) % 5 == 0)
+        game_set_constraint(g, i, j, game_nb_neighbors(sol, i, j, BLACK));
+  nb = game_nb_solutions_ext(g, &one);
+  bigint *nb1 = game_nb_solutions_ext(g, &three);
+  bigint *nb2 = game_nb_solutions_ext(g, &rowdp3);
+  ASSERT(!bigint_is_zero(nb));
+  ASSERT(bigint_cmp(nb, nb1) == 0 && bigint_cmp(nb, nb2) == 0);
+  bigint_free(nb);
+  bigint_free(nb1);
+  bigint_free(nb2);
+  game_delete(sol);
+  game_delete(g);
+  return true;
+}
+
+/* ********** TEST GAME NB SOLUTIONS LEVELS ********** */
+
+bool test_game_nb_solutions_levels() {
+  solver_stats stats[PROPAGATION_PROBE + 1];
+  bigint *nb[PROPAGATION_PROBE + 1];
+  game g = game_new_empty_ext(6, 7, true, FULL);
+  for (uint i = 0; i < 6; i++)
+    for (uint j = 0; j < 7; j++)
+      if ((i * 7 + j * 3) % 4 != 0) game_set_constraint(g, i, j, (i + j) % 4);
+  for (propagation_level l = PROPAGATION_COUNT; l <= PROPAGATION_PROBE; l++) {
+    solver_options opts = {SOLVER_SEARCH, 0, 0, l, &stats[l]};
+    nb[l] = game_nb_solutions_ext(g, &opts);
+    ASSERT(stats[l].time >= 0);
+  }
+  ASSERT(bigint_cmp(nb[PROPAGATION_COUNT], nb[PROPAGATION_TABLE]) == 0);
+  ASSERT(bigint_cmp(nb[PROPAGATION_COUNT], nb[PROPAGATION_LINEAR]) == 0);
+  ASSERT(bigint_cmp(nb[PROPAGATION_COUNT], nb[PROPAGATION_PROBE]) == 0);
+  ASSERT(stats[PROPAGATION_COUNT].nb_probes == 0);
+  ASSERT(stats[PROPAGATION_TABLE].nb_nodes <=
+         stats[PROPAGATION_COUNT].nb_nodes);
+  for (propagation_level l = PROPAGATION_COUNT; l <= PROPAGATION_PROBE; l++)
+    bigint_free(nb[l]);
+  game_delete(g);
+
+  // the default game is solved by propagation alone
+  g = game_default();
+  solver_options probe = {SOLVER_SEARCH, 0, 0, PROPAGATION_PROBE, &stats[0]};
+  ASSERT(game_solve_ext(g, &probe));
+  ASSERT(stats[0].nb_nodes == 0);
+  ASSERT(game_won(g));
+  game_delete(g);
+  return true;
+}
+
+/* ********** SMALL GAMES ********** */
+
+/* Builds the t-th small game (t < 16): 3 or 4 rows of 4 columns, in every
+ * neighbourhood, wrapping or not, with two thirds of the clues of a coloring.
+ * Most of them have one or several solutions; games 7 and 15 have none (a
+ * clue of 9 among four orthogonal neighbours). */
+static game small_game(uint t) {
+  uint nb_rows = 3 + t % 2, nb_cols = 4;
+  game g = game_new_empty_ext(nb_rows, nb_cols, (t / 4) % 2, t % 4);
+  game sol = game_copy(g);
+  for (uint i = 0; i < nb_rows; i++)
+    for (uint j = 0; j < nb_cols; j++)
+      game_set_color(sol, i, j,
+                     (i * j + i + 2 * j + t) % 3 == 0 ? BLACK : WHITE);
+  for (uint i = 0; i < nb_rows; i++)
+    for (uint j = 0; j < nb_cols; j++)
+      if ((i * 5 + j * 3 + t) % 3 != 0)
+        game_set_constraint(g, i, j, game_nb_neighbors(sol, i, j, BLACK));
+  if (t % 8 == 7) game_set_constraint(g, 0, 0, MAX_CONSTRAINT);
+  game_delete(sol);
+  return g;
+}
+
+/* Counts the solutions of a small game by enumerating its colorings, and the
+ * number of them in which each cell is black. */
+static uint64_t brute_count(cgame g, uint64_t *black) {
+  uint nb_cols = game_nb_cols(g), n = game_nb_rows(g) * nb_cols;
+  uint64_t nb = 0;
+  for (uint x = 0; x < n; x++) black[x] = 0;
+  game h = game_copy(g);
+  for (uint m = 0; m < (1u << n); m++) {
+    for (uint x = 0; x < n; x++)
+      game_set_color(h, x / nb_cols, x % nb_cols, (m >> x & 1) ? BLACK : WHITE);
+    if (!game_won(h)) continue;
+    nb++;
+    for (uint x = 0; x < n; x++) black[x] += m >> x & 1;
+  }
+  game_delete(h);
+  return nb;
+}
+
+/* Computes the backbone of a small game from the enumeration of its
+ * colorings. */
+static bool brute_backbone(cgame g, color *fixed) {
+  uint64_t black[4 * 5];
+  uint64_t nb = brute_count(g, black);
+  for (uint x = 0; x < game_nb_rows(g) * game_nb_cols(g); x++) {
+    fixed[x] = EMPTY;
+    if (nb > 0 && black[x] == 0) fixed[x] = WHITE;
+    if (nb > 0 && black[x] == nb) fixed[x] = BLACK;
+  }
+  return nb > 0;
+}
+
+/* ********** TEST GAME BACKBONE ********** */
+
+bool test_game_backbone() {
+  // a unique solution is its own backbone
+  game g = game_default();
+  game sol = game_default_solution();
+  color fixed[DEFAULT_SIZE * DEFAULT_SIZE];
+  ASSERT(game_backbone(g, fixed));
+  for (uint i = 0; i < DEFAULT_SIZE; i++)
+    for (uint j = 0; j < DEFAULT_SIZE; j++)
+      ASSERT(fixed[i * DEFAULT_SIZE + j] == game_get_color(sol, i, j));
+  game_delete(sol);
+  game_delete(g);
+
+  // small games with several solutions, or none
+  color expected[4 * 4];
+  for (uint t = 0; t < 16; t++) {
+    g = small_game(t);
+    ASSERT(game_backbone(g, fixed) == brute_backbone(g, expected));
+    for (uint x = 0; x < game_nb_rows(g) * 4; x++)
+      ASSERT(fixed[x] == expected[x]);
+    game_delete(g);
+  }
+
+  // no clue at all: nothing is fixed
+  g = game_new_empty_ext(2, 2, false, ORTHO);
+  ASSERT(game_backbone(g, fixed));
+  for (uint x = 0; x < 4; x++) ASSERT(fixed[x] == EMPTY);
+  game_delete(g);
+  return true;
+}
+
+/* ********** TEST GAME NB SOLUTIONS ESTIMATE ********** */
+
+bool test_game_nb_solutions_estimate() {
+  // small searches are counted exactly: the default game has one solution
+  game g = game_default();
+  solution_estimate est;
+  game_nb_solutions_estimate(g, 0.01, &est);
+  ASSERT(est.log10_estimate == 0.0 && est.log10_low == 0.0);
+  ASSERT(est.log10_high == 0.0 && est.nb_probes == 0);
+  game_delete(g);
+
+  // free squares only: 2^12 solutions
+  g = game_new_empty_ext(3, 4, false, FULL);
+  game_nb_solutions_estimate(g, 0.01, &est);
+  ASSERT(fabs(est.log10_estimate - 12 * log10(2.0)) < 1e-9);
+  ASSERT(est.log10_low == est.log10_estimate);
+  ASSERT(est.log10_high == est.log10_estimate);
+  game_delete(g);
+
+  // a clue larger than its neighbourhood: no solution
+  g = game_new_empty_ext(2, 2, false, ORTHO);
+  game_set_constraint(g, 0, 0, 4);
+  game_nb_solutions_estimate(g, 0.01, &est);
+  ASSERT(est.log10_estimate == -INFINITY && est.log10_high == -INFINITY);
+  game_delete(g);
+
+  // a grid too large to be counted by a small search, with the clues of a
+  // coloring
+  g = game_new_empty_ext(10, 10, false, FULL);
+  for (int i = 0; i < 10; i++)
+    for (int j = 0; j < 10; j++) {
+      if ((i * 3 + j * 5) % 3 != 0) continue;
+      uint nb_black = 0;
+      for (int a = i - 1; a <= i + 1; a++)
+        for (int b = j - 1; b <= j + 1; b++)
+          if (a >= 0 && b >= 0 && a < 10 && b < 10)
+            nb_black += (a * a + 3 * b + a * b) % 5 < 2;
+      game_set_constraint(g, i, j, nb_black);
+    }
+  bigint *nb = game_nb_solutions_ext(g, NULL);
+  double exact = log10(bigint_to_double(nb));
+  bigint_free(nb);
+  // a number of probes rather than a time budget: the same estimate on any
+  // machine, however loaded
+  srand(0);
+  game_nb_solutions_estimate_ext(g, 0.0, 2000, &est);
+  ASSERT(est.nb_probes >= 2000 && est.nb_probes < 2100);
+  ASSERT(est.log10_low <= est.log10_estimate);
+  ASSERT(est.log10_estimate <= est.log10_high);
+  ASSERT(est.log10_low <= exact && exact <= est.log10_high);
+  ASSERT(fabs(est.log10_estimate - exact) < 0.3);
+  solution_estimate est2;
+  srand(0);
+  game_nb_solutions_estimate_ext(g, 0.0, 2000, &est2);
+  ASSERT(est2.nb_probes == est.nb_probes);
+  ASSERT(est2.log10_estimate == est.log10_estimate);
+  game_delete(g);
+  return true;
+}
+
+/* ********** TEST GAME NB SOLUTIONS MARGINALS ********** */
+
+bool test_game_nb_solutions_marginals() {
+  // the default game: one solution
+  game g = game_default();
+  game sol = game_default_solution();
+  bigint *black[DEFAULT_SIZE * DEFAULT_SIZE];
+  bigint *nb = game_nb_solutions_marginals(g, black);
+  ASSERT(nb && bigint_to_u64(nb) == 1);
+  for (uint i = 0; i < DEFAULT_SIZE; i++)
+    for (uint j = 0; j < DEFAULT_SIZE; j++) {
+      bigint *b = black[i * DEFAULT_SIZE + j];
+      ASSERT(bigint_to_u64(b) == (game_get_color(sol, i, j) == BLACK));
+      bigint_free(b);
+    }
+  bigint_free(nb);
+  game_delete(sol);
+  game_delete(g);
+
+  // small games, against the enumeration of their colorings
+  uint64_t expected[4 * 5];
+  for (uint t = 0; t < 16; t++) {
+    g = small_game(t);
+    uint64_t nb_expected = brute_count(g, expected);
+    nb = game_nb_solutions_marginals(g, black);
+    ASSERT(nb && bigint_to_u64(nb) == nb_expected);
+    for (uint x = 0; x < game_nb_rows(g) * 4; x++) {
+      ASSERT(bigint_to_u64(black[x]) == expected[x]);
+      bigint_free(black[x]);
+    }
+    bigint_free(nb);
+    game_delete(g);
+  }
+
+  // a wrapping game with half of the clues of a coloring (counted by the
+  // cache engine)
+  g = game_new_empty_ext(4, 5, true, FULL);
+  sol = game_new_empty_ext(4, 5, true, FULL);
+  for (uint i = 0; i < 4; i++)
+    for (uint j = 0; j < 5; j++)
+      game_set_color(sol, i, j, (i * j + i + 2 * j) % 3 == 0 ? BLACK : WHITE);
+  for (uint i = 0; i < 4; i++)
+    for (uint j = 0; j < 5; j++)
+      if ((i + j) % 2 == 0)
+        game_set_constraint(g, i, j, game_nb_neighbors(sol, i, j, BLACK));
+  uint64_t nb_expected = brute_count(g, expected);
+  nb = game_nb_solutions_marginals(g, black);
+  ASSERT(nb && bigint_to_u64(nb) == nb_expected && nb_expected > 1);
+  for (uint x = 0; x < 4 * 5; x++) {
+    ASSERT(bigint_to_u64(black[x]) == expected[x]);
+    bigint_free(black[x]);
+  }
+  bigint_free(nb);
+  game_delete(sol);
+  game_delete(g);
+  return true;
+}
+
+/* ********** TEST GAME DIAGRAM ********** */
+
+bool test_game_diagram() {
+  // the default game: one solution, its own backbone
+  game g = game_default();
+  game sol = game_default_solution();
+  diagram d = diagram_compile(g);
+  ASSERT(d && diagram_is_unique(d));
+  color fixed[DEFAULT_SIZE * DEFAULT_SIZE];
+  ASSERT(diagram_backbone(d, fixed));
+  for (uint i = 0; i < DEFAULT_SIZE; i++)
+    for (uint j = 0; j < DEFAULT_SIZE; j++)
+      ASSERT(fixed[i * DEFAULT_SIZE + j] == game_get_color(sol, i, j));
+  ASSERT(diagram_sample(d, g) && game_equal(g, sol));
+
+  // saved and loaded back
+  FILE *f = tmpfile();
+  ASSERT(diagram_save(d, f));
+  rewind(f);
+  diagram e = diagram_load(f);
+  ASSERT(e && diagram_nb_nodes(e) == diagram_nb_nodes(d));
+  bigint *nb = diagram_nb_solutions(e);
+  ASSERT(bigint_to_u64(nb) == 1);
+  bigint_free(nb);
+  diagram_delete(e);
+  fclose(f);
+  f = tmpfile();
+  fprintf(f, "2 2 3 2\n0 1 2 3\n4 1 1\n");
+  rewind(f);
+  ASSERT(diagram_load(f) == NULL);
+  fclose(f);
+  diagram_delete(d);
+  game_delete(sol);
+  game_delete(g);
+
+  // small games: the k-th solutions are all the solutions, once each
+  color expected[4 * 4];
+  uint64_t black[4 * 4];
+  for (uint t = 0; t < 16; t++) {
+    g = small_game(t);
+    uint nb_rows = game_nb_rows(g), nb_cols = 4;
+    d = diagram_compile(g);
+    ASSERT(d);
+    nb = diagram_nb_solutions(d);
+    uint64_t nb_solutions = bigint_to_u64(nb);
+    ASSERT(nb_solutions == brute_count(g, black));
+    ASSERT(diagram_is_unique(d) == (nb_solutions == 1));
+    ASSERT(diagram_backbone(d, fixed) == brute_backbone(g, expected));
+    for (uint x = 0; x < nb_rows * nb_cols; x++)
+      ASSERT(fixed[x] == expected[x]);
+
+    static bool seen[1 << 16];
+    memset(seen, 0, sizeof(seen));
+    bigint *k = bigint_new(0), *one = bigint_new(1);
+    for (uint64_t m = 0; m < nb_solutions; m++) {
+      ASSERT(diagram_solution(d, k, g) && game_won(g));
+      uint mask = 0;
+      for (uint x = 0; x < nb_rows * nb_cols; x++)
+        if (game_get_color(g, x / nb_cols, x % nb_cols) == BLACK) {
+          mask |= 1 << x;
+          black[x]--;
+        }
+      ASSERT(!seen[mask]);
+      seen[mask] = true;
+      bigint_add(k, one);
+    }
+    ASSERT(!diagram_solution(d, k, g));
+    for (uint x = 0; x < nb_rows * nb_cols; x++) ASSERT(black[x] == 0);
+    ASSERT(diagram_sample(d, g) == (nb_solutions > 0));
+    ASSERT(nb_solutions == 0 || game_won(g));
+    bigint_free(k);
+    bigint_free(one);
+    bigint_free(nb);
+    diagram_delete(d);
+    game_delete(g);
+  }
+
+  // a wrapping grid: its first rows stay in the states of the whole sweep,
+  // until the clues around the seam are closed
+  solver_options cache = {SOLVER_CACHE};
+  sol = game_new_empty_ext(8, 8, true, FULL);
+  g = game_new_empty_ext(8, 8, true, FULL);
+  for (uint i = 0; i < 8; i++)
+    for (uint j = 0; j < 8; j++)
+      game_set_color(sol, i, j,
+                     (i * i + 3 * j + i * j) % 5 < 2 ? BLACK : WHITE);
+  for (uint i = 0; i < 8; i++)
+    for (uint j = 0; j < 8; j++)
+      if ((i + 2 * j) % 3 != 0)
+        game_set_constraint(g, i, j, game_nb_neighbors(sol, i, j, BLACK));
+  d = diagram_compile(g);
+  ASSERT(d);
+  nb = diagram_nb_solutions(d);
+  bigint *expected_nb = game_nb_solutions_ext(g, &cache);
+  ASSERT(bigint_cmp(nb, expected_nb) == 0 && !bigint_is_zero(nb));
+  bigint_free(expected_nb);
+  bigint_free(nb);
+  diagram_delete(d);
+  game_delete(sol);
+  game_delete(g);
   return true;
 }
+
+/* ********** TEST GAME DIAGRAM SAMPLE ********** */
+
+bool test_game_diagram_sample() {
+  // default games with fewer clues: each of their solutions is drawn about
+  // as often as the others
+  srand(0);
+  const uint nb_squares = DEFAULT_SIZE * DEFAULT_SIZE;
+  color colors[DEFAULT_SIZE * DEFAULT_SIZE];
+  for (uint t = 1; t < 4; t++) {
+    game g = game_default();
+    for (uint i = 0; i < DEFAULT_SIZE; i++)
+      for (uint j = 0; j < DEFAULT_SIZE; j++)
+        if ((i * 3 + j + t) % 4 == 0) game_set_constraint(g, i, j, -1);
+    diagram d = diagram_compile(g);
+    ASSERT(d);
+    bigint *nb = diagram_nb_solutions(d);
+    uint64_t nb_solutions = bigint_to_u64(nb);
+    bigint_free(nb);
+    ASSERT(nb_solutions >= 2 && nb_solutions <= 64);
+
+    // the solutions, as masks of black squares
+    uint masks[64], drawn[64] = {0};
+    bigint *k = bigint_new(0), *one = bigint_new(1);
+    for (uint m = 0; m < nb_solutions; m++) {
+      ASSERT(diagram_solution(d, k, g));
+      masks[m] = 0;
+      for (uint x = 0; x < nb_squares; x++)
+        if (game_get_color(g, x / DEFAULT_SIZE, x % DEFAULT_SIZE) == BLACK)
+          masks[m] |= 1u << x;
+      bigint_add(k, one);
+    }
+    bigint_free(k);
+    bigint_free(one);
+
+    // 2000 draws per solution: 6 standard deviations are about 270
+    for (uint n = 0; n < 2000 * nb_solutions; n++) {
+      ASSERT(diagram_sample_colors(d, colors));
+      uint mask = 0;
+      for (uint x = 0; x < nb_squares; x++)
+        if (colors[x] == BLACK) mask |= 1u << x;
+      uint m = 0;
+      while (m < nb_solutions && masks[m] != mask) m++;
+      ASSERT(m < nb_solutions);
+      drawn[m]++;
+    }
+    for (uint m = 0; m < nb_solutions; m++)
+      ASSERT(drawn[m] > 2000 - 270 && drawn[m] < 2000 + 270);
+    diagram_delete(d);
+    game_delete(g);
+  }
+
+  // no solution: the colors are unchanged
+  game g = game_new_empty_ext(2, 2, false, ORTHO);
+  game_set_constraint(g, 0, 0, 4);
+  diagram d = diagram_compile(g);
+  ASSERT(d);
+  colors[0] = EMPTY;
+  ASSERT(!diagram_sample_colors(d, colors) && colors[0] == EMPTY);
+  diagram_delete(d);
+  game_delete(g);
+
+  // a large grid with a huge number of solutions
+  g = game_new_empty_ext(12, 40, false, FULL);
+  d = diagram_compile(g);
+  ASSERT(d);
+  for (uint n = 0; n < 100; n++) {
+    ASSERT(diagram_sample(d, g));
+    ASSERT(game_won(g));
+  }
+  diagram_delete(d);
+  game_delete(g);
+  return true;
+}
+
+/* ********** TEST GAME EXPORT ********** */
+
+/* Checks the rows of an OPB export under the colors of a game. */
+static bool opb_holds(FILE *f, cgame g) {
+  rewind(f);
+  uint nb_cols = game_nb_cols(g);
+  char tok[64];
+  long sum = 0, w = 0, need = 0;
+  bool ok = true;
+  while (fscanf(f, "%63s", tok) == 1) {
+    if (tok[0] == '*') {
+      ASSERT(fscanf(f, "%*[^\n]") == 0);
+    } else if (tok[0] == '+') {
+      w = atol(tok + 1);
+    } else if (tok[0] == 'x') {
+      long x = atol(tok + 1) - 1;
+      if (game_get_color(g, x / nb_cols, x % nb_cols) == BLACK) sum += w;
+    } else if (strcmp(tok, "=") == 0) {
+      ASSERT(fscanf(f, "%ld", &need) == 1);
+      if (sum != need) ok = false;
+      sum = 0;
+    }
+  }
+  return ok;
+}
+
+/* Runs unit propagation on a CNF export, the cell variables being set to the
+ * colors of a game. Returns false on a conflict. */
+static bool cnf_propagates(FILE *f, cgame g) {
+  rewind(f);
+  char line[1024];
+  unsigned long nb_vars = 0, nb_clauses = 0;
+  while (fgets(line, sizeof(line), f) && line[0] == 'c') continue;
+  ASSERT(sscanf(line, "p cnf %lu %lu", &nb_vars, &nb_clauses) == 2);
+  uint len = 0, capacity = 1024;
+  long *lits = malloc(capacity * sizeof(long));
+  int *val = calloc(nb_vars + 1, sizeof(int));
+  ASSERT(lits && val);
+  while (fscanf(f, "%ld", &lits[len]) == 1)
+    if (++len == capacity) {
+      capacity *= 2;
+      lits = realloc(lits, capacity * sizeof(long));
+      ASSERT(lits);
+    }
+  uint nb_cols = game_nb_cols(g);
+  for (uint x = 0; x < game_nb_rows(g) * nb_cols; x++)
+    val[x + 1] = game_get_color(g, x / nb_cols, x % nb_cols) == BLACK ? 1 : -1;
+
+  bool ok = true, changed = true;
+  while (ok && changed) {
+    changed = false;
+    for (uint r = 0; r < len && ok; r++) {
+      uint nb_free = 0;
+      long unit = 0;
+      bool sat = false;
+      for (; lits[r] != 0; r++) {
+        int v = val[labs(lits[r])];
+        if (v == 0) {
+          nb_free++;
+          unit = lits[r];
+        } else if ((v > 0) == (lits[r] > 0)) {
+          sat = true;
+        }
+      }
+      if (sat || nb_free > 1) continue;
+      if (nb_free == 0) ok = false;  // falsified clause
+      if (nb_free == 1) {
+        val[labs(unit)] = unit > 0 ? 1 : -1;
+        changed = true;
+      }
+    }
+  }
+  free(lits);
+  free(val);
+  return ok;
+}
+
+/* Checks that both exports of a solved game hold under its colors, and that
+ * flipping a cell covered by a clue breaks both of them. */
+static void check_export(game sol, uint i, uint j) {
+  FILE *cnf = tmpfile(), *opb = tmpfile();
+  game_export_cnf(sol, cnf);
+  game_export_opb(sol, opb);
+  ASSERT(opb_holds(opb, sol));
+  ASSERT(cnf_propagates(cnf, sol));
+  color c = game_get_color(sol, i, j);
+  game_set_color(sol, i, j, c == BLACK ? WHITE : BLACK);
+  ASSERT(!opb_holds(opb, sol));
+  ASSERT(!cnf_propagates(cnf, sol));
+  game_set_color(sol, i, j, c);
+  fclose(cnf);
+  fclose(opb);
+}
+
+bool test_game_export() {
+  game g = game_default();
+  FILE *f = tmpfile();
+  game_export_cnf(g, f);
+  rewind(f);
+  char line[1024];
+  unsigned long nb_vars = 0, nb_clauses = 0, nb_lines = 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == 'p')
+      ASSERT(sscanf(line, "p cnf %lu %lu", &nb_vars, &nb_clauses) == 2);
+    else if (line[0] != 'c')
+      nb_lines++;
+  }
+  ASSERT(nb_vars >= DEFAULT_SIZE * DEFAULT_SIZE);
+  ASSERT(nb_clauses == nb_lines && nb_lines > 0);
+  fclose(f);
+
+  f = tmpfile();
+  game_export_opb(g, f);
+  rewind(f);
+  unsigned long nb_cons = 0;
+  nb_lines = 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '*')
+      ASSERT(sscanf(line, "* #variable= %lu #constraint= %lu", &nb_vars,
+                    &nb_cons) == 2);
+    else
+      nb_lines++;
+  }
+  ASSERT(nb_vars == DEFAULT_SIZE * DEFAULT_SIZE && nb_cons == nb_lines);
+  fclose(f);
+
+  // the model of the default solution, with an auxiliary variable
+  game sol = game_default_solution();
+  f = tmpfile();
+  fprintf(f, "c model\ns SATISFIABLE\nv");
+  for (uint i = 0; i < DEFAULT_SIZE; i++)
+    for (uint j = 0; j < DEFAULT_SIZE; j++)
+      fprintf(f, " %s%u", game_get_color(sol, i, j) == BLACK ? "" : "-",
+              i * DEFAULT_SIZE + j + 1);
+  fprintf(f, " -%u 0\n", DEFAULT_SIZE * DEFAULT_SIZE + 1);
+  rewind(f);
+  ASSERT(game_import_model(g, f));
+  ASSERT(game_equal(g, sol));
+  fclose(f);
+
+  // no model
+  game_restart(g);
+  f = tmpfile();
+  fprintf(f, "s UNSATISFIABLE\n");
+  rewind(f);
+  ASSERT(!game_import_model(g, f));
+  game_delete(sol);
+  sol = game_default();
+  ASSERT(game_equal(g, sol));
+  fclose(f);
+
+  // the encodings hold under the solution, with and without weights (a
+  // wrapping grid of 2 rows counts its cells twice)
+  game_delete(sol);
+  sol = game_default_solution();
+  check_export(sol, 2, 2);
+  game h = game_new_empty_ext(2, 3, true, FULL);
+  for (uint i = 0; i < 2; i++)
+    for (uint j = 0; j < 3; j++)
+      game_set_color(h, i, j, (i + 2 * j) % 3 == 0 ? BLACK : WHITE);
+  for (uint i = 0; i < 2; i++)
+    for (uint j = 0; j < 3; j++)
+      game_set_constraint(h, i, j, game_nb_neighbors(h, i, j, BLACK));
+  ASSERT(game_won(h));
+  check_export(h, 0, 0);
+  game_delete(h);
+
+  game_delete(sol);
+  game_delete(g);
+  return true;
+}
+
 /* ********** MAIN ROUTE ********** */
 
 int main(int argc, char *argv[]) {
@@ -219,6 +1098,30 @@ int main(int argc, char *argv[]) {
     ok = test_game_nb_cols();
   } else if (strcmp("game_nb_solutions", argv[1]) == 0) {
     ok = test_game_nb_solutions();
+  } else if (strcmp("game_nb_solutions_ext", argv[1]) == 0) {
+    ok = test_game_nb_solutions_ext();
+  } else if (strcmp("game_nb_solutions_levels", argv[1]) == 0) {
+    ok = test_game_nb_solutions_levels();
+  } else if (strcmp("game_nb_solutions_cache", argv[1]) == 0) {
+    ok = test_game_nb_solutions_cache();
+  } else if (strcmp("game_nb_solutions_classes", argv[1]) == 0) {
+    ok = test_game_nb_solutions_classes();
+  } else if (strcmp("game_nb_solutions_free", argv[1]) == 0) {
+    ok = test_game_nb_solutions_free();
+  } else if (strcmp("game_nb_solutions_components", argv[1]) == 0) {
+    ok = test_game_nb_solutions_components();
+  } else if (strcmp("game_nb_solutions_estimate", argv[1]) == 0) {
+    ok = test_game_nb_solutions_estimate();
+  } else if (strcmp("game_nb_solutions_marginals", argv[1]) == 0) {
+    ok = test_game_nb_solutions_marginals();
+  } else if (strcmp("game_backbone", argv[1]) == 0) {
+    ok = test_game_backbone();
+  } else if (strcmp("game_diagram", argv[1]) == 0) {
+    ok = test_game_diagram();
+  } else if (strcmp("game_diagram_sample", argv[1]) == 0) {
+    ok = test_game_diagram_sample();
+  } else if (strcmp("game_export", argv[1]) == 0) {
+    ok = test_game_export();
   } else {
     fprintf(stderr, "Error: test \"%s\" not found!\n", argv[1]);
     exit(EXIT_FAILURE);
@@ -1,13 +1,23 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "game_tools.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "game.h"
 #include "game_aux.h"
 #include "game_ext.h"
+#include "game_private.h"
+#include "game_solver.h"
+
+// Widest grid counted with the row DP engine when no engine is selected (and
+// the grid does not wrap)
+#define AUTO_ROWDP_WIDTH 10
 
 /* ************************************************************************** */
 /* ********** CONVERTERS ********** */
@@ -73,20 +83,6 @@ void verify_ret(int ret, int target, char *filename) {
     exit(EXIT_FAILURE);
   }
 }
-// Verify malloc result
-void verify_malloc(game *tab) {
-  if (tab == NULL) {
-    fprintf(stderr, "Not enough memory\n");
-    exit(EXIT_FAILURE);
-  }
-}
-// Free game table
-void freeGameTab(game *tab, uint cmpt) {
-  for (uint i = 0; i < cmpt; i++) {
-    game_delete(tab[i]);
-  }
-  free(tab);
-}
 /* ************************************************************************** */
 
 // Load game from file
@@ -170,60 +166,124 @@ void game_save(cgame g, char *filename) {
 
 /* ************************************************************************** */
 
-uint genMoves(int pos, game g, uint cmpt, game **tab) {
-  if (pos == game_nb_cols(g) * game_nb_rows(g)) {
-    if (game_won(g)) {
-      game_print(g);
-      *tab = realloc(*tab, (cmpt + 1) * sizeof(game));
-      (*tab)[cmpt] = game_copy(g);
+// Get the current time in seconds
+static double _now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
-      return cmpt + 1;
-    }
-    return cmpt;
-  }
+// Fill the statistics of a call, if requested
+static void _fill_stats(const solver_options *opts, const solver *s,
+                        double start) {
+  if (opts->stats == NULL) return;
+  opts->stats->nb_nodes = s->nb_nodes;
+  opts->stats->nb_probes = s->nb_probes;
+  opts->stats->nb_conflicts = s->nb_conflicts;
+  opts->stats->time = _now() - start;
+}
 
-  // Calculate the position
-  uint y = pos % game_nb_cols(g);
-  uint x = pos / game_nb_cols(g);
+// Solve the game
+bool game_solve(game g) { return game_solve_ext(g, NULL); }
 
-  // Play the moves WHITE + BLACK
-  for (color c = WHITE; c <= BLACK; c++) {
-    game_set_color(g, x, y, c);
-    if (game_get_status(g, x, y) != ERROR) {
-      cmpt = genMoves(pos + 1, g, cmpt, tab);
-    }
-    game_set_color(g, x, y, EMPTY);
-  }
+// Solve the game with given options
+bool game_solve_ext(game g, const solver_options *opts) {
+  solver_options defaults = {0};
+  if (opts == NULL) opts = &defaults;
+  double start = _now();
+  solver *s = solver_new(g, false, opts->propagation);
+  bool found = solver_solve_components(s, opts);
+  if (found) solver_export(s, g);
+  _fill_stats(opts, s, start);
+  solver_delete(s);
+  return found;
+}
 
-  return cmpt;
+// Compute the squares with the same color in all the solutions
+bool game_backbone(cgame g, color *fixed) {
+  solver *s = solver_new(g, false, PROPAGATION_DEFAULT);
+  bool found = cdcl_backbone(s, fixed);
+  solver_delete(s);
+  return found;
 }
 
-// Solve the game
-bool game_solve(game g) {
-  game *tab = NULL;
-  game gg = game_copy(g);
-  game_restart(gg);
-
-  int nb_sol = genMoves(0, gg, 0, &tab);
-  if (nb_sol > 0) {
-    for (uint i = 0; i < game_nb_rows(g); i++) {
-      for (uint j = 0; j < game_nb_cols(g); j++) {
-        game_set_constraint(g, i, j, game_get_constraint(tab[0], i, j));
-        game_set_color(g, i, j, game_get_color(tab[0], i, j));
-      }
+// Count the number of solutions
+uint64_t game_nb_solutions(cgame g) {
+  bigint *nb = game_nb_solutions_ext(g, NULL);
+  uint64_t nb_solutions = bigint_to_u64(nb);
+  bigint_free(nb);
+  return nb_solutions;
+}
+
+// Count the exact number of solutions with a given engine
+bigint *game_nb_solutions_ext(cgame g, const solver_options *opts) {
+  solver_options defaults = {0};
+  if (opts == NULL) opts = &defaults;
+  double start = _now();
+  solver *s = solver_new(g, false, opts->propagation);
+  bigint *nb = NULL;
+
+  if (s->conflict) {
+    nb = bigint_new(0);
+  } else {
+    uint width = MIN(s->nb_rows, s->nb_cols);
+    // the wrapping grids keep their first lines in the states of the row
+    // DP sweep: the cache engine splits them into components much faster
+    bool rowdp = (opts->engine == SOLVER_ROWDP) ||
+                 (opts->engine == SOLVER_AUTO && width <= AUTO_ROWDP_WIDTH &&
+                  !s->wrapping);
+    if (rowdp && width <= ROWDP_MAX_WIDTH) nb = rowdp_count(s);
+    if (nb == NULL) {
+      // the grids the row DP engine gives up on go to the default engines
+      solver_options others = *opts;
+      if (others.engine == SOLVER_ROWDP) others.engine = SOLVER_AUTO;
+      nb = solver_count_components(s, &others);
     }
   }
-  game_delete(gg);
-  freeGameTab(tab, nb_sol);
-  return nb_sol > 0;
+
+  _fill_stats(opts, s, start);
+  solver_delete(s);
+  return nb;
 }
 
-// Count the number of solutions
-uint game_nb_solutions(cgame g) {
-  game g_copy = game_copy(g);
-  game *tab = NULL;
-  uint nb_solutions = genMoves(0, g_copy, 0, &tab);
-  game_delete(g_copy);
-  freeGameTab(tab, nb_solutions);
-  return nb_solutions;
-}
\ No newline at end of file
+// Estimate the number of solutions within a time budget
+void game_nb_solutions_estimate(cgame g, double budget,
+                                solution_estimate *est) {
+  solver *s = solver_new(g, false, PROPAGATION_DEFAULT);
+  estimate_count(s, budget, 0, est);
+  solver_delete(s);
+}
+
+// Estimate the number of solutions with a number of probes
+void game_nb_solutions_estimate_ext(cgame g, double budget, uint64_t max_probes,
+                                    solution_estimate *est) {
+  solver *s = solver_new(g, false, PROPAGATION_DEFAULT);
+  estimate_count(s, budget, max_probes, est);
+  solver_delete(s);
+}
+
+// Count the solutions with each square black
+bigint *game_nb_solutions_marginals(cgame g, bigint **black) {
+  solver *s = solver_new(g, false, PROPAGATION_DEFAULT);
+  for (uint x = 0; x < s->nb_cells; x++) black[x] = bigint_new(0);
+  bigint *nb = NULL;
+  bool narrow = MIN(s->nb_rows, s->nb_cols) <= ROWDP_MAX_WIDTH;
+  if (s->conflict) {
+    nb = bigint_new(0);
+  } else if (narrow && !s->wrapping) {
+    nb = rowdp_marginals(s, black);
+  }
+  // the wrapping grids, and the ones the row DP engine gives up on, go to the
+  // cache engine, with the same bound on the width to keep its cost down
+  if (nb == NULL && narrow) {
+    for (uint x = 0; x < s->nb_cells; x++) bigint_set_u64(black[x], 0);
+    nb = cache_marginals(s, 0, black);
+  }
+  if (nb == NULL)
+    for (uint x = 0; x < s->nb_cells; x++) {
+      bigint_free(black[x]);
+      black[x] = NULL;
+    }
+  solver_delete(s);
+  return nb;
+}
@@ -9,10 +9,147 @@
 #ifndef __GAME_TOOLS_H__
 #define __GAME_TOOLS_H__
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include "bigint.h"
 #include "game.h"
 
+/**
+ * @brief The different solver engines.
+ */
+typedef enum {
+  SOLVER_AUTO,   /**< The engine is chosen according to the game. */
+  SOLVER_SEARCH, /**< Backtracking search with constraint propagation. */
+  SOLVER_ROWDP,  /**< Row-by-row dynamic programming (counting only), on
+                    grids whose narrower side is at most ROWDP_MAX_WIDTH and
+                    whose sweep does not have too many states (the engine
+                    is chosen as with SOLVER_AUTO otherwise). */
+  SOLVER_CACHE,  /**< Search splitting into components at each node, with
+                    the counts of the components cached (counting only). */
+  SOLVER_CDCL    /**< Conflict-driven clause learning on the constraints
+                    (solving only, counting uses the search engine). It is
+                    the engine of SOLVER_AUTO for a sequential solve. */
+} solver_engine;
+
+/**
+ * @brief The different levels of propagation, from the weakest to the
+ * strongest (and slowest).
+ */
+typedef enum {
+  PROPAGATION_DEFAULT, /**< The default level, i.e. PROPAGATION_TABLE. */
+  PROPAGATION_COUNT,   /**< Counters only: a saturated constraint forces its
+                          empty cells white, a tight one forces them black. */
+  PROPAGATION_TABLE,   /**< Counters, then the feasible patterns of each
+                          constraint filtered by the overlapping ones. */
+  PROPAGATION_LINEAR,  /**< Tables, then linear reasoning: the equations of
+                          each constraint and of its overlapping ones are
+                          reduced by integer elimination, and bounds on the
+                          reduced equations force cells. */
+  PROPAGATION_PROBE    /**< Linear reasoning, then failed-literal probing:
+                          each undecided cell is tried in both colors, and
+                          fixed if one of them leads to a conflict. */
+} propagation_level;
+
+/**
+ * @brief Solver statistics.
+ */
+typedef struct {
+  uint64_t nb_nodes;  /**< number of branches tried by the search */
+  uint64_t nb_probes; /**< number of colors tried by the probing */
+  uint64_t nb_conflicts; /**< number of conflicts met by the CDCL engine */
+  double time;        /**< elapsed time, in seconds */
+} solver_stats;
+
+/**
+ * @brief Maximal width of the grids counted by the row DP engine.
+ **/
+#define ROWDP_MAX_WIDTH 20
+
+/**
+ * @brief Solver options.
+ * @details Passing NULL instead of options selects the default ones, i.e. all
+ * fields set to zero.
+ */
+typedef struct {
+  solver_engine engine; /**< the engine to use */
+  uint nb_threads;      /**< number of threads of the search engine (0 or 1
+                           for a sequential search) */
+  size_t cache_size;    /**< memory budget of the cache engine, in bytes (0
+                           for the default one, 256 MiB) */
+  propagation_level propagation; /**< the propagation level */
+  solver_stats* stats;  /**< if not NULL, filled with the statistics of the
+                           call */
+} solver_options;
+
+/**
+ * @brief An estimate of the number of solutions, with its 95% confidence
+ * interval.
+ * @details The values are decimal logarithms (-INFINITY for 0), so that the
+ * estimates of large grids do not overflow: the estimate is about
+ * 10^log10_estimate solutions.
+ */
+typedef struct {
+  double log10_estimate; /**< the estimated number of solutions */
+  double log10_low;      /**< lower bound of the confidence interval */
+  double log10_high;     /**< upper bound of the confidence interval */
+  uint64_t nb_probes;    /**< number of random probes of the search tree */
+} solution_estimate;
+
+/**
+ * @brief The rules of the logical solver, from the simplest to the hardest.
+ */
+typedef enum {
+  RULE_TRIVIAL,   /**< A 0 clue makes its squares white, and a clue equal to
+                     the size of its neighbourhood makes them black. */
+  RULE_SATURATED, /**< A clue with enough black squares makes its other
+                     squares white, and a clue with just enough empty squares
+                     left makes them black. */
+  RULE_PAIR,      /**< Overlap and subset reasoning: the needs of two clues
+                     bound the number of black squares they share, which forces
+                     the shared squares or the squares of one clue only. */
+  RULE_CHAIN      /**< One color of a square leads to a contradiction with the
+                     simpler rules, so the square takes the other color. */
+} logic_rule;
+
+/**
+ * @brief The difficulty grades, given by the hardest rule needed.
+ */
+typedef enum {
+  DIFFICULTY_TRIVIAL, /**< Trivial clues only. */
+  DIFFICULTY_EASY,    /**< Saturated clues. */
+  DIFFICULTY_MEDIUM,  /**< Pairs of clues. */
+  DIFFICULTY_HARD,    /**< Chains. */
+  DIFFICULTY_UNSOLVED /**< The rules are not enough: the game needs guesses,
+                         or has several solutions, or none. */
+} difficulty;
+
+/**
+ * @brief A deduction of the logical solver.
+ */
+typedef struct {
+  uint i, j;             /**< the deduced square */
+  color c;               /**< its color */
+  logic_rule rule;       /**< the rule applied */
+  uint clue_i, clue_j;   /**< the clue of the rule (for a chain, the clue
+                            where the contradiction appears) */
+  uint other_i, other_j; /**< the other clue of a pair (or the same clue) */
+} deduction;
+
+/**
+ * @brief The incremental state of the hints of a game.
+ */
+typedef struct hint_s* hint_state;
+
+/**
+ * @brief The answers of the dead-end detection.
+ */
+typedef enum {
+  DEADEND_NONE,   /**< The colors can still be completed into a solution. */
+  DEADEND_FOUND,  /**< The colors cannot be completed any more. */
+  DEADEND_UNKNOWN /**< The search budget ran out before an answer. */
+} deadend_status;
+
 /**
  * @name Game Tools
  * @{
@@ -43,13 +180,249 @@ void game_save(cgame g, char* filename);
  */
 bool game_solve(game g);
 
+/**
+ * @brief Computes the solution of a given game with extended options.
+ * @param g the game to solve
+ * @param opts the solver options (or NULL for the default ones)
+ * @details Same as @ref game_solve. With several threads, the search tree is
+ * split into tasks shared by all the threads, and all of them stop as soon as
+ * one finds a solution (which is then not always the same one). With
+ * SOLVER_CDCL, the conflict-driven engine is used instead (on one thread).
+ * SOLVER_AUTO also uses the conflict-driven engine, unless several threads
+ * are asked for: its learnt clauses prune sparse puzzles that the search
+ * keeps exploring (a 30x30 grid with half of the clues takes milliseconds
+ * instead of seconds), and it costs no more on easy ones. Its cost still grows
+ * faster than the grid: with half of the clues, a random 100x100 grid takes
+ * about 0.25 s, a 150x150 one about 1 s, and a 200x200 one 3 to 5 s (3 to 5
+ * million decisions, 25 to 45 thousand conflicts), or more on a slower
+ * machine. Most of these decisions are replayed after the backjumps, which
+ * undo the unrelated regions of the grid as well.
+ * @return true if a solution is found, false otherwise
+ */
+bool game_solve_ext(game g, const solver_options* opts);
+
 /**
  * @brief Computes the total number of solutions of a given game.
  * @param g the game
- * @details The game @p g must be unchanged.
- * @return the number of solutions
+ * @details The game @p g must be unchanged. Solutions are only counted, none
+ * of them is stored.
+ * @return the number of solutions (saturated at UINT64_MAX)
+ */
+uint64_t game_nb_solutions(cgame g);
+
+/**
+ * @brief Computes the exact number of solutions of a given game.
+ * @param g the game
+ * @param opts the solver options (or NULL for the default ones)
+ * @details The game @p g must be unchanged. With SOLVER_AUTO, the row DP
+ * engine is used on grids whose narrower side is small enough, unless they
+ * wrap, and the cache engine otherwise, whatever the number of threads. The
+ * search engine runs on opts->nb_threads threads.
+ * @return the number of solutions, to be freed with bigint_free()
+ */
+bigint* game_nb_solutions_ext(cgame g, const solver_options* opts);
+
+/**
+ * @brief Estimates the number of solutions of a game within a time budget.
+ * @details Random branches of the search tree are followed down (Knuth's
+ * estimator): each decision where both colors survive propagation doubles
+ * the estimate of a branch, which is 0 if it ends in a conflict. Their mean is
+ * an unbiased estimate of the number of solutions. The independent parts of
+ * the grid are estimated separately (or counted, if small), and probes are
+ * run until the budget is spent, with rand(). The interval is a normal
+ * approximation, raised to 1 once a solution is met: it can be badly off when
+ * solutions are rare. If no probe meets a solution, the estimate is 0 with an
+ * infinite upper bound (unknown), unless the game has no solution for sure.
+ * The colors of the game are ignored.
+ * @param g the game
+ * @param budget the time budget, in seconds
+ * @param est the estimate
+ */
+void game_nb_solutions_estimate(cgame g, double budget, solution_estimate* est);
+
+/**
+ * @brief Estimates the number of solutions of a game with a number of probes.
+ * @details Same as @ref game_nb_solutions_estimate, but the probes also stop
+ * once there are at least @p max_probes of them (a round probes each
+ * component left once). With a time budget of 0, only the number of probes
+ * counts: after srand(), the estimate does not depend on the machine. With
+ * both at 0, a single round is run.
+ * @param g the game
+ * @param budget the time budget, in seconds (0 for none)
+ * @param max_probes the number of probes (0 for none)
+ * @param est the estimate
+ */
+void game_nb_solutions_estimate_ext(cgame g, double budget, uint64_t max_probes,
+                                    solution_estimate* est);
+
+/**
+ * @brief Counts the solutions of a game, and for each square the solutions
+ * where it is black.
+ * @details All the counts come from a single forward and backward sweep of
+ * the row DP engine, instead of one count per pinned square. On wrapping
+ * grids (or if the sweep has too many states), they come from a single search
+ * of the cache engine instead, where each component caches the counts of its
+ * cells being black along with its own count.
+ * The narrower side of the grid must be at most ROWDP_MAX_WIDTH, even on
+ * wrapping grids where the row DP engine is not used: the width bounds the
+ * cost of both engines. The colors of the game are ignored. The ratio
+ * black[x] / count is the probability of square x to be black in a solution
+ * drawn at random, e.g. for a heatmap.
+ * @param g the game
+ * @param black array of nb_rows * nb_cols counters (row-major), each set to a
+ * new big integer, to be freed with bigint_free() (all set to NULL if the
+ * grid is too wide)
+ * @return the number of solutions, to be freed with bigint_free(), or NULL if
+ * the narrower side of the grid is wider than ROWDP_MAX_WIDTH, whether the
+ * grid wraps or not
+ */
+bigint* game_nb_solutions_marginals(cgame g, bigint** black);
+
+/**
+ * @brief Computes the backbone of a game: the squares with the same color in
+ * all its solutions.
+ * @details Solutions are not enumerated: the conflict-driven engine finds one
+ * solution, then tries the other color of each square left under an
+ * assumption, keeping what it learns between the calls. The colors of the
+ * game are ignored, as in @ref game_solve.
+ * @param g the game
+ * @param fixed array of nb_rows * nb_cols colors (row-major), set to the color
+ * of each square of the backbone, and to EMPTY for the other squares
+ * @return true if the game has a solution, false otherwise (all the squares
+ * are then EMPTY)
+ */
+bool game_backbone(cgame g, color* fixed);
+
+/**
+ * @brief Exports a game as a CNF formula, in the DIMACS format.
+ * @details Cell (i, j) is the variable i * nb_cols + j + 1, true if the cell is
+ * black; the other variables are auxiliary. Each constrained square is
+ * encoded with a sequential counter, whose counters known in advance are
+ * replaced by constants. The formula is written as it is built, in two
+ * passes (the first one counts the variables and clauses of the header). The
+ * colors of the game are ignored, as in @ref game_solve.
+ * @param g the game
+ * @param f the output file
+ */
+void game_export_cnf(cgame g, FILE* f);
+
+/**
+ * @brief Exports a game as a pseudo-boolean problem, in the OPB format.
+ * @details Cell (i, j) is the variable x(i * nb_cols + j + 1), true if the
+ * cell is black, and each constrained square is a linear equation. The colors
+ * of the game are ignored.
+ * @param g the game
+ * @param f the output file
+ */
+void game_export_opb(cgame g, FILE* f);
+
+/**
+ * @brief Reads the model found by a SAT or pseudo-boolean solver.
+ * @details The literals are read from the "v" lines of the competition
+ * format, or from the lines of bare literals (e.g. "1 -2 3 0" or "x1 -x2").
+ * Comment, status and objective lines are skipped, and the auxiliary
+ * variables are ignored.
+ * @param g the game, whose colors are set to the model
+ * @param f the input file
+ * @return true if the model gives a color to every cell, false otherwise (for
+ * instance if the solver reports an unsatisfiable problem), in which case
+ * @p g is unchanged
+ */
+bool game_import_model(game g, FILE* f);
+
+/**
+ * @brief Solves a game with logical rules only, as a human would.
+ * @details The rules (see @ref logic_rule) are applied from the simplest one,
+ * going back to the simplest one after each deduction, and never guessing.
+ * The current colors of the game are kept and used by the rules.
+ * @param g the game, updated with the deduced colors (unchanged if the rules
+ * lead to a contradiction)
+ * @param steps if not NULL, set to the array of the deductions in order, to be
+ * freed with free()
+ * @param nb_steps if not NULL, set to the number of deductions
+ * @return the difficulty, given by the hardest rule used, or
+ * DIFFICULTY_UNSOLVED if the game is not complete at the end
+ */
+difficulty game_solve_logic(game g, deduction** steps, uint* nb_steps);
+
+/**
+ * @brief Grades a game with the logical solver.
+ * @details Same as @ref game_solve_logic, on a copy of the game.
+ * @param g the game
+ * @return the difficulty of the game
+ */
+difficulty game_grade(cgame g);
+
+/**
+ * @brief Creates the incremental state of the hints of a game.
+ * @details The state follows the colors of the game from one hint to the
+ * next: only the clues around the squares changed since the last hint are
+ * checked again, so that consecutive hints after a few moves are cheap.
+ * @param g the game
+ * @return the state, to be deleted with @ref hint_delete
+ */
+hint_state hint_new(cgame g);
+
+/**
+ * @brief Deletes the incremental state of the hints.
+ * @param h the state
+ */
+void hint_delete(hint_state h);
+
+/**
+ * @brief Finds an empty square forced by the current colors of a game.
+ * @details The square is forced by a single clue (RULE_TRIVIAL or
+ * RULE_SATURATED) if any, or else by a pair of clues (RULE_PAIR). Chains are
+ * not tried. The game is not modified, the move is left to the player.
+ * @param h the state of the hints, created for this game (see @ref hint_new)
+ * @param g the game, with the same size as when the state was created
+ * @param d the hint: the square, its color and the clues forcing it
+ * @return true if a square is found, false if none is forced by these rules
+ * or if the current colors already break a clue
+ */
+bool hint_next(hint_state h, cgame g, deduction* d);
+
+/**
+ * @brief Finds an empty square forced by the current colors of a game.
+ * @details One-shot wrapper: same as @ref hint_next with a new state, deleted
+ * afterwards. Building the state reads the whole game (about 5 ms on a
+ * 100x100 grid, against 0.05 ms for @ref hint_next), so a game followed move
+ * after move should keep a state from @ref hint_new instead.
+ * @param g the game
+ * @param i the row of the square (output)
+ * @param j the column of the square (output)
+ * @param c the color of the square (output)
+ * @param clue_i the row of the clue forcing the square (output, may be NULL)
+ * @param clue_j the column of the clue forcing the square (output, may be
+ * NULL)
+ * @return true if a square is found, false otherwise
+ */
+bool game_hint(cgame g, uint* i, uint* j, color* c, uint* clue_i,
+               uint* clue_j);
+
+/**
+ * @brief Decides whether the current colors of a game can still be completed
+ * into a solution.
+ * @details The rules of @ref hint_next are applied first, then each component
+ * left is searched, within a budget of search nodes. On a dead end, the clues
+ * involved are collected (those of the contradiction, and those that deduced
+ * its squares), then reduced by dropping each clue in turn while the others
+ * are still a dead end. The result is minimal unless the budget runs out on
+ * the way. The rules are not charged: they take about 6 ms on a 100x100 grid.
+ * The budget pays for the search nodes, and for building each component
+ * searched, one node per 16 of its cells, so that the rest of the call grows
+ * with the budget only: under 0.1 ms per node on a 100x100 grid.
+ * @param g the game, unchanged
+ * @param budget the maximal number of search nodes, building the components
+ * included (0 for the rules only)
+ * @param clues set to the array of the squares of the clues, as
+ * i * nb_cols + j, to be freed with free() (NULL if there is no dead end)
+ * @param nb_clues set to the number of clues
+ * @return DEADEND_FOUND on a dead end, DEADEND_NONE if a solution is found,
+ * or DEADEND_UNKNOWN if the budget is not enough
  */
-uint game_nb_solutions(cgame g);
+deadend_status game_dead_end(cgame g, uint64_t budget, uint** clues,
+                             uint* nb_clues);
 
 /**
  * @}